@@ -5,60 +5,745 @@
 #include <err.h>
 #include <errno.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sysexits.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <sys/syscall.h>
+
+// size of the chunks into which --lines input is cut
+#define CHUNK_SIZE (1 << 20)
+
+#define MAX_JOBS 1024
+
+// number of random bytes that follow the input in --vanity candidates by default
+#define VANITY_TAIL 20
+
+// error code for a record of invalid hex, alongside the library's error codes
+#define EHEX (-128)
 
 
 static void print_usage() {
-	fprintf(stderr, "usage: %s [-d] [-h]\n\n"
+	fprintf(stderr, "usage: %s [-d [--trusted]] [-h] [--raw] [-i FILE] [-o FILE] [-l [-k] [-j N] [--stats]]\n"
+		"       %s --vanity=PREFIX [-h] [--tail=N] [--matches=N] [-j N] [--stats]\n"
+		"       %s --pack [--index] [-k] [-i FILE] [-o FILE] [--stats]\n"
+		"       %s --unpack [-j N] [-i FILE] [-o FILE] [--stats]\n\n"
 		"Reads data from stdin, encodes it in Base58Check, and writes the encoding to\n"
-		"stdout. Specify -d to decode instead. Specify -h to use hex data input/output.\n",
-		program_invocation_short_name);
+		"stdout. Specify -d to decode instead. Specify -h to use hex data input/output.\n"
+		"Specify -i and -o to read from and write to files instead of stdin and stdout.\n"
+		"Specify -l to encode or decode each line of stdin as a separate record, and -k\n"
+		"to keep going after a bad record, writing an error line in its place. Specify\n"
+		"-j to convert records in N threads, and --stats to report throughput. Specify\n"
+		"--raw to use plain Base58 without a checksum, or --trusted to decode without\n"
+		"verifying checksums.\n\n"
+		"With --vanity, searches for encodings that begin with PREFIX of the data from\n"
+		"stdin followed by N random bytes (default %d), writing each one found to\n"
+		"stdout, until as many have been found as --matches says (default 1). The\n"
+		"search runs in N threads given by -j (default one per CPU), and --stats\n"
+		"reports the rate at which candidates were tried.\n\n"
+		"With --pack, decodes each line of stdin and writes the payloads to stdout as\n"
+		"a binary pack, with an index of record offsets if --index is given; -k leaves\n"
+		"out bad records instead of failing. With --unpack, encodes each record of a\n"
+		"pack from stdin as a line of stdout, in N threads given by -j (default one\n"
+		"per CPU).\n",
+		program_invocation_short_name, program_invocation_short_name,
+		program_invocation_short_name, program_invocation_short_name, VANITY_TAIL);
 }
 
-static int gethex() {
+// Decodes the n_in hex digits at in into out, which may be the same buffer.
+// Returns the number of bytes decoded or -1 if the hex is invalid.
+static ssize_t unhex(unsigned char out[], const char in[], size_t n_in) {
 	static const int8_t DECODE['f' + 1 - '0'] = {
 		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
 		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
 		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
 		-1, 10, 11, 12, 13, 14, 15
 	};
-	int hi, lo;
-	if ((hi = getchar()) < 0)
-		return hi;
-	if ((hi -= '0') >= 0 && hi <= 'f' - '0' && (hi = DECODE[hi]) >= 0) {
-		if ((lo = getchar()) >= 0 && (lo -= '0') >= 0 && lo <= 'f' - '0' && (lo = DECODE[lo]) >= 0)
-			return hi << 4 | lo;
+	if (n_in % 2)
+		return -1;
+	for (size_t i = 0; i < n_in; i += 2) {
+		int hi = (unsigned char) in[i] - '0', lo = (unsigned char) in[i + 1] - '0';
+		if (hi < 0 || hi > 'f' - '0' || (hi = DECODE[hi]) < 0 ||
+				lo < 0 || lo > 'f' - '0' || (lo = DECODE[lo]) < 0)
+			return -1;
+		out[i / 2] = (unsigned char) (hi << 4 | lo);
 	}
-	else if (hi == '\n' - '0')
-		return EOF;
-	errx(EX_DATAERR, "invalid hex on stdin");
+	return (ssize_t) (n_in / 2);
 }
 
-static ssize_t fwrite_hex(const unsigned char in[], size_t n_in, FILE *out) {
+// Writes the hex digits of in[0..n_in) to out and returns the end of them.
+static char * tohex(char out[], const unsigned char in[], size_t n_in) {
 	static const char ENCODE[16] = {
 		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
 	};
-	for (size_t i = 0; i < n_in; ++i) {
-		char x[2] = { ENCODE[in[i] >> 4], ENCODE[in[i] & 0xF] };
-		if (fwrite(x, 1, 2, out) < 2)
-			return -1;
+	for (size_t i = 0; i < n_in; ++i)
+		*out++ = ENCODE[in[i] >> 4], *out++ = ENCODE[in[i] & 0xF];
+	return out;
+}
+
+static const char * error_message(int error) {
+	switch (error) {
+		case BASE58CHECK_ECHAR:
+			return "invalid Base58 character";
+		case BASE58CHECK_ELENGTH:
+			return "encoding is too short";
+		case BASE58CHECK_ECHECKSUM:
+			return "checksum mismatch";
+		case BASE58CHECK_ESIZE:
+			return "record is too large";
+		case BASE58CHECK_EFORMAT:
+			return "pack is corrupt";
+		case EHEX:
+			return "invalid hex";
+	}
+	return "not a valid Base58Check encoding";
+}
+
+// A heap buffer that is reused from record to record and only ever grows.
+struct buffer {
+	void *data;
+	size_t size;
+};
+
+// Returns a pointer to buf[pos], with room for size bytes there.
+static void * reserve(struct buffer *buf, size_t pos, size_t size) {
+	if (__builtin_uaddl_overflow(pos, size, &size))
+		errx(EX_OSERR, "out of memory");
+	if (size > buf->size) {
+		if (size < buf->size * 2)
+			size = buf->size * 2;
+		void *data = realloc(buf->data, size);
+		if (!data)
+			err(EX_OSERR, "out of memory");
+		buf->data = data, buf->size = size;
+	}
+	return (char *) buf->data + pos;
+}
+
+// Converts one record, writing the output, terminated by a newline, at
+// out[pos]. Returns the size of the output or a negative error code.
+static ssize_t convert_record(struct base58check_ctx *ctx, struct buffer *out, size_t pos, struct buffer *tmp, const char in[], size_t n_in, bool decode, bool hex, unsigned flags) {
+	int ret;
+	size_t n_out;
+	if (decode) {
+		if ((n_out = base58check_decode_buffer_size(in, n_in, 1)) == SIZE_MAX)
+			return BASE58CHECK_ESIZE;
+		unsigned char *bin = reserve(hex ? tmp : out, hex ? 0 : pos, n_out);
+		if ((ret = base58check_decode_ex(ctx, &bin, &n_out, in, n_in, 0, flags)) < 0)
+			return ret;
+		if (hex) {
+			if (n_out > (SIZE_MAX - 1) / 2)
+				return BASE58CHECK_ESIZE;
+			char *h = reserve(out, pos, n_out * 2 + 1);
+			n_out = (size_t) (tohex(h, bin, n_out) - h);
+		}
+	}
+	else {
+		const unsigned char *bin = (const unsigned char *) in;
+		if (hex) {
+			ssize_t n_bin = unhex(reserve(tmp, 0, n_in / 2 + 1), in, n_in);
+			if (n_bin < 0)
+				return EHEX;
+			bin = tmp->data, n_in = (size_t) n_bin;
+		}
+		if ((n_out = base58check_encode_buffer_size(bin, n_in, 1)) == SIZE_MAX)
+			return BASE58CHECK_ESIZE;
+		char *enc = reserve(out, pos, n_out);
+		if ((ret = base58check_encode_ex(ctx, &enc, &n_out, bin, n_in, 0, flags)) < 0)
+			errx(EX_SOFTWARE, "internal error");
+	}
+	((char *) out->data)[pos + n_out++] = '\n';
+	return (ssize_t) n_out;
+}
+
+struct options {
+	bool decode, hex, keep_going;
+	unsigned flags;
+};
+
+// A run of whole lines of input and the output converted from them. In a
+// pipeline, turn counts the chunk's passes through the reader, worker, and
+// writer stages, so a chunk of sequence number seq is ready for stage s when
+// its turn is seq / N_CHUNKS * 3 + s.
+struct chunk {
+	uint32_t turn;
+	bool end;
+	const char *in; // either in_buf or a span of the mapped input
+	size_t n_in;
+	char *in_buf;
+	size_t in_size;
+	struct buffer out;
+	size_t n_out;
+	uintmax_t n_lines, n_errors;
+	int error; // the error that stopped conversion at line n_lines of the chunk
+};
+
+struct reader {
+	int fd;
+	const char *name;
+	char *map; // the whole input, if it could be mapped
+	size_t map_size, map_pos;
+	char *carry; // a partial line left over from the previous chunk
+	size_t n_carry, carry_size;
+	double wait;
+};
+
+struct worker {
+	const struct options *opts;
+	struct pipeline *pipeline;
+	struct base58check_ctx *ctx;
+	struct buffer tmp;
+	pthread_t thread;
+	double wait;
+};
+
+struct writer {
+	const struct options *opts;
+	struct pipeline *pipeline;
+	int fd;
+	const char *name;
+	char *map; // the output file, if it could be mapped, grown as needed
+	size_t map_size, pos;
+	uintmax_t n_lines, n_errors;
+	pthread_t thread;
+	double wait;
+};
+
+struct pipeline {
+	struct chunk *chunks;
+	size_t n_chunks;
+	uint64_t next_seq; // the next chunk for a worker to claim
+};
+
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+// Waits until *turn is want, adding any time spent waiting to *wait.
+static void await_turn(uint32_t *turn, uint32_t want, double *wait) {
+	uint32_t seen = __atomic_load_n(turn, __ATOMIC_ACQUIRE);
+	if (seen == want)
+		return;
+	double start = now();
+	do
+		syscall(SYS_futex, turn, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+	while ((seen = __atomic_load_n(turn, __ATOMIC_ACQUIRE)) != want);
+	*wait += now() - start;
+}
+
+// Hands a chunk on to its next stage.
+static void advance_turn(uint32_t *turn) {
+	__atomic_add_fetch(turn, 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, turn, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+// Maps the input if it is a regular file, so that chunks can be cut straight
+// out of the mapping.
+static void open_input(struct reader *r, const char *name) {
+	if (!name) {
+		r->fd = STDIN_FILENO, r->name = "stdin";
+		return;
 	}
-	return putc('\n', out) < 0 ? -1 : (ssize_t) n_in;
+	if ((r->fd = open(name, O_RDONLY | O_CLOEXEC)) < 0)
+		err(EX_NOINPUT, "%s", name);
+	r->name = name;
+	struct stat st;
+	if (fstat(r->fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uintmax_t) st.st_size > SIZE_MAX)
+		return;
+	void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+	if (map == MAP_FAILED)
+		return;
+	madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+	madvise(map, (size_t) st.st_size, MADV_HUGEPAGE);
+#endif
+	r->map = map, r->map_size = (size_t) st.st_size;
+}
+
+static void close_input(struct reader *r) {
+	if (r->map)
+		munmap(r->map, r->map_size);
+	if (r->fd != STDIN_FILENO)
+		close(r->fd);
+	free(r->carry);
+}
+
+// Resizes the mapped output file to size bytes.
+static void resize_output(struct writer *w, size_t size) {
+	if (ftruncate(w->fd, (off_t) size) < 0)
+		err(EX_IOERR, "%s", w->name);
+	void *map = w->map ? mremap(w->map, w->map_size, size, MREMAP_MAYMOVE) :
+			mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0);
+	if (map == MAP_FAILED)
+		err(EX_IOERR, "%s", w->name);
+	madvise(map, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+	madvise(map, size, MADV_HUGEPAGE);
+#endif
+	w->map = map, w->map_size = size;
+}
+
+// Creates the output file and, if it is a regular file, maps it at the
+// estimated size of the output.
+static void open_output(struct writer *w, const char *name, size_t estimate) {
+	if (!name) {
+		w->fd = STDOUT_FILENO, w->name = "stdout";
+		return;
+	}
+	if ((w->fd = open(name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)) < 0)
+		err(EX_CANTCREAT, "%s", name);
+	w->name = name;
+	struct stat st;
+	if (fstat(w->fd, &st) == 0 && S_ISREG(st.st_mode) && estimate)
+		resize_output(w, estimate);
+}
+
+// Unmaps the output file and truncates it to the size actually written.
+static void close_output(struct writer *w) {
+	if (w->map) {
+		munmap(w->map, w->map_size);
+		w->map = NULL;
+		if (ftruncate(w->fd, (off_t) w->pos) < 0)
+			err(EX_IOERR, "%s", w->name);
+	}
+	if (w->fd != STDOUT_FILENO && close(w->fd) < 0)
+		err(EX_IOERR, "%s", w->name);
+}
+
+static void write_output(struct writer *w, const char *buf, size_t n) {
+	if (w->map) {
+		if (n > w->map_size - w->pos)
+			resize_output(w, w->pos + n > w->map_size * 2 ? w->pos + n : w->map_size * 2);
+		memcpy(w->map + w->pos, buf, n);
+		w->pos += n;
+		return;
+	}
+	while (n) {
+		ssize_t written = write(w->fd, buf, n);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EX_IOERR, "error writing to %s", w->name);
+		}
+		buf += written, n -= (size_t) written;
+	}
+}
+
+// Fills c with whole lines of input, plus the final line if it is not
+// terminated. Returns false if there was no more input.
+static bool read_chunk(struct reader *r, struct chunk *c) {
+	if (r->map) {
+		const char *p = r->map + r->map_pos, *nl;
+		size_t n = r->map_size - r->map_pos;
+		if (n > CHUNK_SIZE && (nl = memchr(p + CHUNK_SIZE - 1, '\n', n - (CHUNK_SIZE - 1))))
+			n = (size_t) (nl + 1 - p);
+		r->map_pos += n;
+		c->in = p, c->n_in = n;
+		return n != 0;
+	}
+
+	size_t n = r->n_carry;
+	if (c->in_size < CHUNK_SIZE || c->in_size < n * 2) {
+		free(c->in_buf);
+		if (!(c->in_buf = malloc(c->in_size = n * 2 > CHUNK_SIZE ? n * 2 : CHUNK_SIZE)))
+			err(EX_OSERR, "out of memory");
+	}
+	if (n)
+		memcpy(c->in_buf, r->carry, n);
+	r->n_carry = 0;
+	c->in = c->in_buf;
+	for (;;) {
+		if (n == c->in_size) {
+			const char *nl = memrchr(c->in_buf, '\n', n);
+			if (nl) {
+				size_t n_carry = (size_t) (c->in_buf + n - ++nl);
+				if (n_carry > r->carry_size && !(r->carry = realloc(r->carry, r->carry_size = c->in_size)))
+					err(EX_OSERR, "out of memory");
+				memcpy(r->carry, nl, r->n_carry = n_carry);
+				c->n_in = n - n_carry;
+				return true;
+			}
+			// a single line longer than the whole chunk
+			if (!(c->in = c->in_buf = realloc(c->in_buf, c->in_size *= 2)))
+				err(EX_OSERR, "out of memory");
+		}
+		ssize_t got = read(r->fd, c->in_buf + n, c->in_size - n);
+		if (got < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EX_IOERR, "error reading from %s", r->name);
+		}
+		if (!got)
+			return (c->n_in = n) != 0;
+		n += (size_t) got;
+	}
+}
+
+static void convert_chunk(struct worker *w, struct chunk *c) {
+	const struct options *o = w->opts;
+	c->n_out = 0, c->n_lines = 0, c->n_errors = 0, c->error = 0;
+	for (const char *p = c->in, *end = p + c->n_in; p < end; ++c->n_lines) {
+		const char *nl = memchr(p, '\n', (size_t) (end - p));
+		size_t n = (size_t) ((nl ?: end) - p);
+		if (n && p[n - 1] == '\r')
+			--n;
+		ssize_t n_out = convert_record(w->ctx, &c->out, c->n_out, &w->tmp, p, n, o->decode, o->hex, o->flags);
+		if (n_out >= 0)
+			c->n_out += (size_t) n_out;
+		else if (o->keep_going) {
+			static const char prefix[] = "error: ";
+			const char *msg = error_message((int) n_out);
+			size_t n_msg = strlen(msg);
+			char *q = mempcpy(reserve(&c->out, c->n_out, sizeof prefix + n_msg), prefix, sizeof prefix - 1);
+			memcpy(q, msg, n_msg);
+			q[n_msg] = '\n';
+			c->n_out += sizeof prefix + n_msg;
+			++c->n_errors;
+		}
+		else {
+			c->error = (int) n_out;
+			return;
+		}
+		p = nl ? nl + 1 : end;
+	}
+}
+
+static void write_chunk(struct writer *w, const struct chunk *c) {
+	write_output(w, c->out.data, c->n_out);
+	w->n_lines += c->n_lines, w->n_errors += c->n_errors;
+	if (c->error) {
+		close_output(w);
+		errx(EX_DATAERR, "line %ju: %s", w->n_lines + 1, error_message(c->error));
+	}
+}
+
+static void * worker_main(void *arg) {
+	struct worker *w = arg;
+	struct pipeline *p = w->pipeline;
+	for (;;) {
+		uint64_t seq = __atomic_fetch_add(&p->next_seq, 1, __ATOMIC_RELAXED);
+		struct chunk *c = &p->chunks[seq % p->n_chunks];
+		await_turn(&c->turn, (uint32_t) (seq / p->n_chunks * 3 + 1), &w->wait);
+		// once handed on, the chunk may be refilled, so end must be read first
+		bool end = c->end;
+		if (!end)
+			convert_chunk(w, c);
+		advance_turn(&c->turn);
+		if (end)
+			return NULL;
+	}
+}
+
+static void * writer_main(void *arg) {
+	struct writer *w = arg;
+	struct pipeline *p = w->pipeline;
+	for (uint64_t seq = 0;; ++seq) {
+		struct chunk *c = &p->chunks[seq % p->n_chunks];
+		await_turn(&c->turn, (uint32_t) (seq / p->n_chunks * 3 + 2), &w->wait);
+		if (c->end)
+			return NULL;
+		write_chunk(w, c);
+		advance_turn(&c->turn);
+	}
+}
+
+static struct base58check_ctx * new_ctx() {
+	struct base58check_ctx *ctx = base58check_ctx_new();
+	if (!ctx)
+		err(EX_OSERR, "out of memory");
+	return ctx;
+}
+
+// Estimates the size of the output from the size of the whole input, as
+// though it were one record. The output file is grown if it runs over.
+static size_t estimate_output(const struct options *o, const struct reader *r) {
+	if (!r->map)
+		return 0;
+	size_t n = o->decode ? base58check_decode_buffer_size(r->map, r->map_size, 0) :
+			base58check_encode_buffer_size((const unsigned char *) r->map, o->hex ? r->map_size / 2 : r->map_size, 0);
+	if (o->decode && o->hex)
+		n = n > SIZE_MAX / 2 ? SIZE_MAX : n * 2;
+	// allow for the newlines and per-record overheads of short records
+	return n > SIZE_MAX - n / 8 ? n : n + n / 8;
+}
+
+// Converts the input line by line, through a pipeline of n_jobs worker
+// threads if n_jobs is nonzero.
+static int process_lines(const struct options *o, const char *in_name, const char *out_name, unsigned n_jobs, bool stats) {
+	struct reader reader = { };
+	struct writer writer = { .opts = o };
+	open_input(&reader, in_name);
+	open_output(&writer, out_name, estimate_output(o, &reader));
+	double start = now();
+	if (!n_jobs) {
+		struct worker worker = { .opts = o, .ctx = new_ctx() };
+		struct chunk chunk = { };
+		while (read_chunk(&reader, &chunk)) {
+			convert_chunk(&worker, &chunk);
+			write_chunk(&writer, &chunk);
+		}
+		base58check_ctx_free(worker.ctx);
+		free(worker.tmp.data);
+		free(chunk.in_buf);
+		free(chunk.out.data);
+	}
+	else {
+		// Each worker may hold a chunk while the reader fills one ahead and
+		// the writer drains one behind it.
+		struct pipeline pipeline = { .n_chunks = (size_t) n_jobs * 2 + 2 };
+		struct worker *workers = calloc(n_jobs, sizeof *workers);
+		if (!workers || !(pipeline.chunks = calloc(pipeline.n_chunks, sizeof *pipeline.chunks)))
+			err(EX_OSERR, "out of memory");
+		for (unsigned i = 0; i < n_jobs; ++i) {
+			workers[i] = (struct worker) { .opts = o, .pipeline = &pipeline, .ctx = new_ctx() };
+			if ((errno = pthread_create(&workers[i].thread, NULL, worker_main, &workers[i])))
+				err(EX_OSERR, "pthread_create");
+		}
+		writer.pipeline = &pipeline;
+		if ((errno = pthread_create(&writer.thread, NULL, writer_main, &writer)))
+			err(EX_OSERR, "pthread_create");
+
+		// The input is followed by one end marker for each worker.
+		for (uint64_t seq = 0, n_ends = 0; n_ends < n_jobs; ++seq) {
+			struct chunk *c = &pipeline.chunks[seq % pipeline.n_chunks];
+			await_turn(&c->turn, (uint32_t) (seq / pipeline.n_chunks * 3), &reader.wait);
+			if ((c->end = n_ends || !read_chunk(&reader, c)))
+				++n_ends;
+			advance_turn(&c->turn);
+		}
+		for (unsigned i = 0; i < n_jobs; ++i) {
+			pthread_join(workers[i].thread, NULL);
+			base58check_ctx_free(workers[i].ctx);
+			free(workers[i].tmp.data);
+		}
+		pthread_join(writer.thread, NULL);
+
+		if (stats) {
+			double wait = 0;
+			for (unsigned i = 0; i < n_jobs; ++i)
+				wait += workers[i].wait;
+			fprintf(stderr, "%s: waits: reader %.3f s, workers %.3f s (mean), writer %.3f s\n",
+				program_invocation_short_name, reader.wait, wait / n_jobs, writer.wait);
+		}
+		for (size_t i = 0; i < pipeline.n_chunks; ++i)
+			free(pipeline.chunks[i].in_buf), free(pipeline.chunks[i].out.data);
+		free(pipeline.chunks);
+		free(workers);
+	}
+	close_input(&reader);
+	close_output(&writer);
+
+	if (stats) {
+		double elapsed = now() - start;
+		fprintf(stderr, "%s: %ju records in %.3f s (%.0f records/s), %ju invalid\n",
+			program_invocation_short_name, writer.n_lines, elapsed,
+			elapsed > 0 ? (double) writer.n_lines / elapsed : 0, writer.n_errors);
+	}
+	return writer.n_errors ? EX_DATAERR : EX_OK;
+}
+
+// Returns the whole input, from its mapping or else read into r->carry.
+static const char * read_all(struct reader *r, size_t *n) {
+	if (r->map)
+		return *n = r->map_size, r->map;
+	size_t n_in = 0;
+	for (;;) {
+		if (n_in == r->carry_size && !(r->carry = realloc(r->carry, r->carry_size = r->carry_size ? r->carry_size * 2 : CHUNK_SIZE)))
+			err(EX_OSERR, "out of memory");
+		ssize_t got = read(r->fd, r->carry + n_in, r->carry_size - n_in);
+		if (got < 0) {
+			if (errno == EINTR)
+				continue;
+			err(EX_IOERR, "error reading from %s", r->name);
+		}
+		if (!got)
+			break;
+		n_in += (size_t) got;
+	}
+	return *n = n_in, r->carry;
+}
+
+// Packs the records on the lines of the input. Bad records are reported and,
+// with keep_going, left out of the pack.
+static int pack_lines(const char *in_name, const char *out_name, unsigned flags, bool keep_going, bool stats) {
+	struct reader reader = { };
+	struct writer writer = { };
+	open_input(&reader, in_name);
+	size_t n_in, n_items = 0;
+	const char *in = read_all(&reader, &n_in), *end = in + n_in;
+	double start = now();
+	for (const char *p = in, *nl; p < end; ++n_items)
+		p = (nl = memchr(p, '\n', (size_t) (end - p))) ? nl + 1 : end;
+	struct base58check_item *items = malloc((n_items ?: 1) * sizeof *items);
+	int *results = malloc((n_items ?: 1) * sizeof *results);
+	if (!items || !results)
+		err(EX_OSERR, "out of memory");
+	const char *p = in;
+	for (size_t i = 0; i < n_items; ++i) {
+		const char *nl = memchr(p, '\n', (size_t) (end - p));
+		size_t n = (size_t) ((nl ?: end) - p);
+		if (n && p[n - 1] == '\r')
+			--n;
+		items[i] = (struct base58check_item) { .data = p, .size = n };
+		p = nl ? nl + 1 : end;
+	}
+
+	unsigned char *out = NULL;
+	size_t n_out = 0;
+	switch (base58check_pack_batch(&out, &n_out, items, n_items, flags, results)) {
+		case 0:
+			break;
+		case BASE58CHECK_ESIZE:
+			errx(EX_DATAERR, "%s: input is too large to pack", reader.name);
+		default:
+			errx(EX_OSERR, "out of memory");
+	}
+	uintmax_t n_errors = 0;
+	for (size_t i = 0; i < n_items && (keep_going || !n_errors); ++i)
+		if (results[i]) {
+			warnx("%s:%zu: %s", reader.name, i + 1, error_message(results[i]));
+			++n_errors;
+		}
+
+	if (keep_going || !n_errors) {
+		open_output(&writer, out_name, n_out);
+		write_output(&writer, (const char *) out, n_out);
+		close_output(&writer);
+	}
+	close_input(&reader);
+	if (stats && (keep_going || !n_errors)) {
+		double elapsed = now() - start;
+		fprintf(stderr, "%s: %zu records in %.3f s (%.0f records/s), %ju invalid, %zu bytes packed\n",
+			program_invocation_short_name, n_items, elapsed,
+			elapsed > 0 ? (double) n_items / elapsed : 0, n_errors, n_out);
+	}
+	base58check_free(out);
+	free(items);
+	free(results);
+	return n_errors ? EX_DATAERR : EX_OK;
+}
+
+// Unpacks a pack into lines of encodings, in n_jobs threads or one per CPU.
+// A mapped output file is unpacked into directly.
+static int unpack_lines(const char *in_name, const char *out_name, unsigned n_jobs, bool stats) {
+	struct reader reader = { };
+	struct writer writer = { };
+	open_input(&reader, in_name);
+	size_t n_in, n_need;
+	const char *in = read_all(&reader, &n_in);
+	double start = now();
+	struct base58check_pack pack;
+	if (base58check_pack_open(&pack, in, n_in) < 0)
+		errx(EX_DATAERR, "%s: not a pack", reader.name);
+	if ((n_need = base58check_unpack_buffer_size(&pack)) == SIZE_MAX)
+		errx(EX_DATAERR, "%s: %s", reader.name, error_message(BASE58CHECK_EFORMAT));
+
+	open_output(&writer, out_name, n_need);
+	char *out = writer.map;
+	size_t n_out = writer.map_size;
+	switch (base58check_unpack(&out, &n_out, &pack, n_jobs)) {
+		case 0:
+			break;
+		case BASE58CHECK_EFORMAT:
+			errx(EX_DATAERR, "%s: %s", reader.name, error_message(BASE58CHECK_EFORMAT));
+		default:
+			errx(EX_OSERR, "out of memory");
+	}
+	if (writer.map)
+		writer.pos = n_out;
+	else {
+		write_output(&writer, out, n_out);
+		base58check_free(out);
+	}
+	close_output(&writer);
+	close_input(&reader);
+	if (stats) {
+		double elapsed = now() - start;
+		fprintf(stderr, "%s: %zu records in %.3f s (%.0f records/s)\n",
+			program_invocation_short_name, pack.n_records, elapsed,
+			elapsed > 0 ? (double) pack.n_records / elapsed : 0);
+	}
+	return EX_OK;
+}
+
+static int write_match(void *opaque, const unsigned char *payload, size_t n_payload, const char *encoding, size_t n_encoding) {
+	(void) opaque, (void) payload, (void) n_payload;
+	if (fwrite(encoding, 1, n_encoding, stdout) < n_encoding || putchar('\n') == EOF || fflush(stdout))
+		err(EX_IOERR, "error writing to stdout");
+	return 0;
+}
+
+// Searches for encodings that begin with prefix of the n_head bytes at head
+// followed by n_tail random bytes.
+static int search_vanity(const char *prefix, const unsigned char *head, size_t n_head, size_t n_tail, uint64_t n_matches, unsigned n_jobs, bool stats) {
+	struct base58check_search search = {
+		.prefix = prefix, .n_prefix = strlen(prefix),
+		.head = head, .n_head = n_head, .n_payload = n_head + n_tail,
+		.match = write_match, .max_matches = n_matches, .n_threads = n_jobs,
+	};
+	if (getrandom(&search.seed, sizeof search.seed, 0) < (ssize_t) sizeof search.seed)
+		err(EX_OSERR, "getrandom");
+	struct base58check_search_stats st;
+	switch (base58check_search_prefix(&search, &st)) {
+		case 0:
+			break;
+		case BASE58CHECK_ECHAR:
+			errx(EX_USAGE, "--vanity: prefix contains an invalid Base58 character");
+		case BASE58CHECK_ELENGTH:
+			errx(EX_DATAERR, "--vanity: no encoding of that data can begin with the prefix");
+		default:
+			errx(EX_OSERR, "out of memory");
+	}
+	if (stats)
+		fprintf(stderr, "%s: %" PRIu64 " candidates in %.3f s (%.0f candidates/s), %" PRIu64 " checksums\n",
+			program_invocation_short_name, st.candidates, st.seconds,
+			st.seconds > 0 ? (double) st.candidates / st.seconds : 0, st.checksums);
+	return EX_OK;
 }
 
 int main(int argc, char *argv[]) {
 	static const struct option longopts[] = {
 		{ .name = "decode", .has_arg = no_argument, .val = 'd' },
 		{ .name = "hex", .has_arg = no_argument, .val = 'h' },
+		{ .name = "lines", .has_arg = no_argument, .val = 'l' },
+		{ .name = "keep-going", .has_arg = no_argument, .val = 'k' },
+		{ .name = "jobs", .has_arg = required_argument, .val = 'j' },
+		{ .name = "stats", .has_arg = no_argument, .val = 3 },
+		{ .name = "raw", .has_arg = no_argument, .val = 4 },
+		{ .name = "trusted", .has_arg = no_argument, .val = 5 },
+		{ .name = "input", .has_arg = required_argument, .val = 'i' },
+		{ .name = "output", .has_arg = required_argument, .val = 'o' },
+		{ .name = "vanity", .has_arg = required_argument, .val = 6 },
+		{ .name = "tail", .has_arg = required_argument, .val = 7 },
+		{ .name = "matches", .has_arg = required_argument, .val = 8 },
+		{ .name = "pack", .has_arg = no_argument, .val = 9 },
+		{ .name = "unpack", .has_arg = no_argument, .val = 10 },
+		{ .name = "index", .has_arg = no_argument, .val = 11 },
 		{ .name = "help", .has_arg = no_argument, .val = 1 },
 		{ .name = "version", .has_arg = no_argument, .val = 2 },
 		{ }
 	};
-	bool decode = false, hex = false;
-	for (int opt; (opt = getopt_long(argc, argv, "dh", longopts, NULL)) >= 0;) {
+	struct options o = { };
+	bool lines = false, stats = false, search_opts = false, pack = false, unpack = false, index = false;
+	unsigned long n_jobs = 0, n_tail = VANITY_TAIL;
+	unsigned long long n_matches = 1;
+	const char *in_name = NULL, *out_name = NULL, *vanity = NULL;
+	for (int opt; (opt = getopt_long(argc, argv, "dhlkj:i:o:", longopts, NULL)) >= 0;) {
+		char *end;
 		switch (opt) {
 			case 1:
 				print_usage();
@@ -66,58 +751,139 @@ int main(int argc, char *argv[]) {
 			case 2:
 				printf("base58check %s\n", VERSION);
 				return EX_OK;
+			case 3:
+				stats = true;
+				break;
+			case 4:
+				o.flags |= BASE58CHECK_RAW;
+				break;
+			case 5:
+				o.flags |= BASE58CHECK_TRUSTED;
+				break;
+			case 6:
+				vanity = optarg;
+				break;
+			case 7:
+				n_tail = strtoul(optarg, &end, 10);
+				if (*end || !*optarg || n_tail > 1024)
+					errx(EX_USAGE, "--tail: byte count must be from 0 to 1024");
+				search_opts = true;
+				break;
+			case 8:
+				n_matches = strtoull(optarg, &end, 10);
+				if (*end || !*optarg || !n_matches)
+					errx(EX_USAGE, "--matches: match count must be at least 1");
+				search_opts = true;
+				break;
+			case 9:
+				pack = true;
+				break;
+			case 10:
+				unpack = true;
+				break;
+			case 11:
+				index = true;
+				break;
 			case 'd':
-				decode = true;
+				o.decode = true;
 				break;
 			case 'h':
-				hex = true;
+				o.hex = true;
+				break;
+			case 'l':
+				lines = true;
+				break;
+			case 'k':
+				o.keep_going = true;
+				break;
+			case 'i':
+				in_name = optarg;
+				break;
+			case 'o':
+				out_name = optarg;
+				break;
+			case 'j':
+				n_jobs = strtoul(optarg, &end, 10);
+				if (*end || n_jobs < 1 || n_jobs > MAX_JOBS)
+					errx(EX_USAGE, "-j: job count must be from 1 to %d", MAX_JOBS);
 				break;
 			default:
 				print_usage();
 				return EX_USAGE;
 		}
 	}
-	if (optind != argc)
+	if (optind != argc || ((o.keep_going || n_jobs || stats) && !lines && !vanity && !pack && !unpack) ||
+			(o.flags & BASE58CHECK_TRUSTED && (!o.decode || o.flags & BASE58CHECK_RAW)) ||
+			(vanity && (lines || o.decode || o.flags)) ||
+			(search_opts && !vanity) ||
+			((pack || unpack) && (vanity || lines || o.decode || o.hex || o.flags || pack == unpack)) ||
+			(pack && n_jobs) || (unpack && o.keep_going) || (index && !pack))
 		return print_usage(), EX_USAGE;
+	if (pack)
+		return pack_lines(in_name, out_name, index ? BASE58CHECK_PACK_INDEX : 0, o.keep_going, stats);
+	if (unpack)
+		return unpack_lines(in_name, out_name, (unsigned) n_jobs, stats);
+	if (lines)
+		return process_lines(&o, in_name, out_name, (unsigned) n_jobs, stats);
+	int fd;
+	if (in_name && ((fd = open(in_name, O_RDONLY)) < 0 || dup2(fd, STDIN_FILENO) < 0))
+		err(EX_NOINPUT, "%s", in_name);
+	if (out_name && ((fd = open(out_name, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0 || dup2(fd, STDOUT_FILENO) < 0))
+		err(EX_CANTCREAT, "%s", out_name);
+	bool decode = o.decode, hex = o.hex;
 
-	unsigned char in[4096];
+	char *in = NULL;
 	size_t n_in = 0;
 	if (decode || hex) {
-		for (int c;;) {
-			if (decode ? (c = getchar()) < 0 || c == '\n' : (c = gethex()) < 0) {
-				if (ferror(stdin))
-					err(EX_IOERR, "error reading from stdin");
-				break;
-			}
-			if (n_in == sizeof in)
-				errx(EX_DATAERR, "input is too long");
-			in[n_in++] = (unsigned char) c;
+		size_t n_line = 0;
+		ssize_t n = getline(&in, &n_line, stdin);
+		if (n < 0) {
+			if (ferror(stdin))
+				err(EX_IOERR, "error reading from stdin");
+			n = 0;
 		}
+		else if (in[n - 1] == '\n')
+			--n;
+		if (!decode && (n = unhex((unsigned char *) in, in, (size_t) n)) < 0)
+			errx(EX_DATAERR, "invalid hex on stdin");
+		n_in = (size_t) n;
 	}
 	else {
-		n_in = fread(in, 1, sizeof in, stdin);
-		if (ferror(stdin))
-			err(EX_IOERR, "error reading from stdin");
-		if (!feof(stdin) && getchar() >= 0)
-			errx(EX_DATAERR, "input is too long");
+		for (size_t n_alloc = 0;;) {
+			if (n_in == n_alloc && !(in = realloc(in, n_alloc = n_alloc ? n_alloc * 2 : 4096)))
+				err(EX_OSERR, "out of memory");
+			n_in += fread(in + n_in, 1, n_alloc - n_in, stdin);
+			if (ferror(stdin))
+				err(EX_IOERR, "error reading from stdin");
+			if (feof(stdin))
+				break;
+		}
 	}
+	const char *data = in ?: "";
+	if (vanity)
+		return search_vanity(vanity, (const unsigned char *) data, n_in, n_tail, n_matches, (unsigned) n_jobs, stats);
 
 	unsigned char *out = NULL;
 	size_t n_out = 0;
 	if (decode) {
-		if (base58check_decode(&out, &n_out, (char *) in, n_in, 0))
-			errx(EX_DATAERR, "input was not a valid Base58Check encoding");
+		if (base58check_decode_ex(NULL, &out, &n_out, data, n_in, 0, o.flags))
+			errx(EX_DATAERR, "input was not a valid %s encoding", o.flags & BASE58CHECK_RAW ? "Base58" : "Base58Check");
+		if (hex) {
+			char *h = malloc(n_out * 2 + 1);
+			if (!h)
+				err(EX_OSERR, "out of memory");
+			*tohex(h, out, n_out) = '\n';
+			n_out = n_out * 2 + 1, out = (unsigned char *) h;
+		}
 	}
 	else {
 		n_out = 1;
-		if (base58check_encode((char **) &out, &n_out, in, n_in, 0))
+		if (base58check_encode_ex(NULL, (char **) &out, &n_out, (const unsigned char *) data, n_in, 0, o.flags))
 			errx(EX_SOFTWARE, "internal error");
 		out[n_out++] = '\n';
 	}
 
-	if (hex && decode ?
-			fwrite_hex((const unsigned char *) out, n_out, stdout) < (ssize_t) n_out :
-			fwrite(out, 1, n_out, stdout) < n_out)
+	if (fwrite(out, 1, n_out, stdout) < n_out)
 		err(EX_IOERR, "error writing to stdout");
 
 	return EX_OK;
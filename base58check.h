@@ -1,12 +1,75 @@
 /// @file
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 # define restrict __restrict
 extern "C" {
 #endif
 
+/**
+ * @brief Error codes returned by the functions of this library.
+ */
+enum base58check_error {
+	/** @brief An input was too large or an output buffer was too small. */
+	BASE58CHECK_ESIZE = -1,
+	/** @brief There was a failure to allocate memory. */
+	BASE58CHECK_ENOMEM = -2,
+	/** @brief A Base58Check encoding contained an illegal character. */
+	BASE58CHECK_ECHAR = -3,
+	/** @brief A Base58Check encoding decoded to too few bytes to hold a
+	 * checksum, or to other than the expected number of bytes. */
+	BASE58CHECK_ELENGTH = -4,
+	/** @brief A Base58Check encoding had a checksum mismatch. */
+	BASE58CHECK_ECHECKSUM = -5,
+	/** @brief A Base58Check encoding decoded to data that did not begin with
+	 * the expected version bytes. */
+	BASE58CHECK_EVERSION = -6,
+	/** @brief The library was built without the requested feature. */
+	BASE58CHECK_ENOTSUP = -7,
+	/** @brief A file could not be opened, read, written, or mapped; @c errno
+	 * tells why. */
+	BASE58CHECK_EIO = -8,
+	/** @brief Data that were to be opened as an address set or a pack were
+	 * not one, or a pack was corrupt. */
+	BASE58CHECK_EFORMAT = -9,
+};
+
+/**
+ * @brief Flags accepted by base58check_encode_ex(), base58check_decode_ex(),
+ * and base58check_pack_batch().
+ */
+enum base58check_flags {
+	/** @brief Encode or decode plain Base58, with no checksum appended or
+	 * expected. */
+	BASE58CHECK_RAW = 1 << 0,
+	/** @brief Strip the checksum when decoding without verifying it. For use
+	 * only on encodings whose integrity has already been established. */
+	BASE58CHECK_TRUSTED = 1 << 1,
+	/** @brief Write an index of record offsets when packing records of
+	 * varying sizes, so that any record can be found without scanning. */
+	BASE58CHECK_PACK_INDEX = 1 << 2,
+};
+
+/**
+ * @brief Describes one item of a batch.
+ */
+struct base58check_item {
+	/** @brief A pointer to the data of the item. */
+	const void *data;
+	/** @brief The size in bytes of the data of the item. */
+	size_t size;
+};
+
+/**
+ * @brief The largest payload, including its checksum, whose scratch space is
+ * staged on the stack, with no memory allocated, by calls made without a
+ * context, base58check_verify(), base58check_decode_expect(), and
+ * base58check_prefix_encode().
+ */
+#define BASE58CHECK_STACK_PAYLOAD_SIZE 256
+
 /**
  * @brief Returns the recommended size of a buffer to hold the Base58Check
  * encoding of the specified input data.
@@ -21,9 +84,25 @@ extern "C" {
 size_t base58check_encode_buffer_size(const unsigned char *in, size_t n_in, size_t n_pad)
 	__attribute__ ((__access__ (read_only, 1), __nonnull__, __nothrow__, __pure__));
 
+/**
+ * @brief Returns the recommended size of a buffer to hold the plain Base58
+ * encoding of the specified input data.
+ * @param[in] in A pointer to the input data needing to be encoded. Must not be
+ * @c NULL.
+ * @param n_in The number of bytes of input data at @p in.
+ * @param n_pad The minimum number of excess bytes to include in the returned
+ * estimate.
+ * @return An upper-bound estimate of the size of the Base58 encoding of the
+ * specified input data, or @c SIZE_MAX upon overflow.
+ */
+size_t base58_encode_buffer_size(const unsigned char *in, size_t n_in, size_t n_pad)
+	__attribute__ ((__access__ (read_only, 1), __nonnull__, __nothrow__, __pure__));
+
 /**
  * @brief Returns the recommended size of a buffer to hold the decoding of the
  * specified Base58Check encoding.
+ * @details The estimate also holds for the decoding of a plain Base58
+ * encoding.
  * @param[in] in A pointer to the Base58Check encoding needing to be decoded.
  * Must not be @c NULL.
  * @param n_in The size of the Base58Check encoding at @p in, not including any
@@ -36,6 +115,30 @@ size_t base58check_encode_buffer_size(const unsigned char *in, size_t n_in, size
 size_t base58check_decode_buffer_size(const char *in, size_t n_in, size_t n_pad)
 	__attribute__ ((__access__ (read_only, 1), __nonnull__, __nothrow__, __pure__));
 
+/**
+ * @brief Computes the Base58Check checksum of the specified data.
+ * @param[out] out A pointer to a 4-byte buffer that will receive the first
+ * 4 bytes of the double SHA-256 hash of the input data. Must not be @c NULL.
+ * @param[in] in A pointer to the input data. Must not be @c NULL.
+ * @param n_in The number of bytes of input data at @p in.
+ */
+void base58check_checksum(unsigned char *restrict out, const unsigned char *restrict in, size_t n_in)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Returns the recommended size of a buffer to hold the Base58Check
+ * encodings of the specified batch of input data.
+ * @param[in] in A pointer to an array of @p n_items items describing the input
+ * data needing to be encoded. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @param n_pad The minimum number of excess bytes to include in the returned
+ * estimate.
+ * @return An upper-bound estimate of the combined size of the Base58Check
+ * encodings of the specified input data, or @c SIZE_MAX upon overflow.
+ */
+size_t base58check_encode_batch_buffer_size(const struct base58check_item in[], size_t n_items, size_t n_pad)
+	__attribute__ ((__access__ (read_only, 1, 2), __nonnull__, __nothrow__, __pure__));
+
 /**
  * @brief Encodes data in Base58Check format.
  * @param[in,out] out
@@ -69,7 +172,8 @@ size_t base58check_decode_buffer_size(const char *in, size_t n_in, size_t n_pad)
  * encoding.
  * @return 0 if the encoding was successful, or a negative number upon error,
  * which may be because @p n_in was too large, @c *n_out was too small or too
- * large, @p n_hdr was too large, or there was a failure to allocate memory.
+ * large, @p n_hdr was too large (#BASE58CHECK_ESIZE), or there was a failure to
+ * allocate memory (#BASE58CHECK_ENOMEM).
  */
 int base58check_encode(char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr)
 	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3), __nonnull__, __nothrow__));
@@ -108,13 +212,885 @@ int base58check_encode(char **restrict out, size_t *n_out, const unsigned char *
  * decoded data.
  * @return 0 if the decoding was successful, or a negative number upon error,
  * which may be because @p n_in was too large, @c *n_out was too small or too
- * large, @p n_hdr was too large, the encoding at @p in contained an illegal
- * character, there was a checksum mismatch, or there was a failure to allocate
- * memory.
+ * large, @p n_hdr was too large (#BASE58CHECK_ESIZE), the encoding at @p in
+ * contained an illegal character (#BASE58CHECK_ECHAR), the encoding at @p in
+ * was too short (#BASE58CHECK_ELENGTH), there was a checksum mismatch
+ * (#BASE58CHECK_ECHECKSUM), or there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM).
  */
 int base58check_decode(unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr)
 	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3), __nonnull__, __nothrow__));
 
+/**
+ * @brief Encodes data in plain Base58 format, without a checksum.
+ * @details This function behaves exactly like base58check_encode() except that
+ * no checksum is computed or appended. The size of the buffer it needs is
+ * given by base58_encode_buffer_size().
+ * @param[in,out] out See base58check_encode().
+ * @param[in,out] n_out See base58check_encode().
+ * @param[in] in See base58check_encode().
+ * @param n_in See base58check_encode().
+ * @param n_hdr See base58check_encode().
+ * @return See base58check_encode().
+ */
+int base58_encode(char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr)
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Decodes data from plain Base58 format, without a checksum.
+ * @details This function behaves exactly like base58check_decode() except that
+ * no checksum is expected, so it fails only if the encoding contains an
+ * illegal character (#BASE58CHECK_ECHAR), if a size is out of range
+ * (#BASE58CHECK_ESIZE), or if memory cannot be allocated
+ * (#BASE58CHECK_ENOMEM).
+ * @param[in,out] out See base58check_decode().
+ * @param[in,out] n_out See base58check_decode().
+ * @param[in] in See base58check_decode().
+ * @param n_in See base58check_decode().
+ * @param n_hdr See base58check_decode().
+ * @return See base58check_decode().
+ */
+int base58_decode(unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr)
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Checks whether a string is a valid Base58Check encoding without
+ * decoding it into a caller-supplied buffer.
+ * @details The alphabet is checked, the base conversion is done into scratch
+ * space on the stack, and the checksum is verified. No memory is allocated
+ * unless the decoding would be longer than #BASE58CHECK_STACK_PAYLOAD_SIZE
+ * bytes.
+ * @param[in] in A pointer to the Base58Check encoding to be verified. Must not
+ * be @c NULL.
+ * @param n_in The size of the Base58Check encoding at @p in, not including any
+ * possible terminator.
+ * @param[out] n_decoded A pointer to a variable that will receive the size of
+ * the decoded data, not including the checksum, if the encoding is valid. May
+ * be @c NULL.
+ * @return 0 if the encoding is valid, or a negative number otherwise, which
+ * may be because @p n_in was too large (#BASE58CHECK_ESIZE), the encoding at
+ * @p in contained an illegal character (#BASE58CHECK_ECHAR), the encoding at
+ * @p in was too short (#BASE58CHECK_ELENGTH), there was a checksum mismatch
+ * (#BASE58CHECK_ECHECKSUM), or there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM).
+ */
+int base58check_verify(const char *restrict in, size_t n_in, size_t *restrict n_decoded)
+	__attribute__ ((__access__ (read_only, 1, 2), __access__ (write_only, 3), __nonnull__ (1), __nothrow__));
+
+/**
+ * @brief Decodes a Base58Check encoding of data of a known size that begin
+ * with known version bytes.
+ * @details Encodings that cannot be of the expected format are rejected as
+ * cheaply as possible: the length of the encoding is checked against the
+ * range of lengths that data of the expected size can have, and the leading
+ * '1' characters, which stand for leading zero bytes, against the version, all
+ * before the alphabet is checked. The version of a decoding is then checked
+ * ahead of its checksum, so an encoding of the wrong format never costs a
+ * hash. The base conversion is done into scratch space on the stack, and no
+ * memory is allocated unless the decoding would be longer than
+ * #BASE58CHECK_STACK_PAYLOAD_SIZE bytes.
+ * @param[out] out A pointer to a buffer of @p n_out bytes that will receive
+ * the decoded data, including the version, if the encoding is valid. Must not
+ * be @c NULL.
+ * @param n_out The expected size of the decoded data, including the version
+ * but not the checksum.
+ * @param[in] in A pointer to the Base58Check encoding to be decoded. Must not
+ * be @c NULL.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @param[in] version A pointer to the bytes with which the decoded data are
+ * expected to begin. May be @c NULL if @p n_version is zero.
+ * @param n_version The number of bytes of version at @p version. Must not
+ * exceed @p n_out.
+ * @return 0 if the encoding was valid and of the expected format, or else a
+ * negative number, which is that of the first check to fail: the sizes were
+ * out of range (#BASE58CHECK_ESIZE), the encoding could not be of data of the
+ * expected size (#BASE58CHECK_ELENGTH), the encoding could not begin with the
+ * version (#BASE58CHECK_EVERSION), the encoding contained an illegal
+ * character (#BASE58CHECK_ECHAR), the decoded data were not of the expected
+ * size (#BASE58CHECK_ELENGTH) or did not begin with the version
+ * (#BASE58CHECK_EVERSION), there was a checksum mismatch
+ * (#BASE58CHECK_ECHECKSUM), or there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM). Nothing is written to @p out unless 0 is returned.
+ */
+int base58check_decode_expect(unsigned char *restrict out, size_t n_out, const char *restrict in, size_t n_in, const unsigned char *restrict version, size_t n_version)
+	__attribute__ ((__access__ (write_only, 1, 2), __access__ (read_only, 3, 4), __access__ (read_only, 5, 6), __nonnull__ (1, 3), __nothrow__));
+
+/**
+ * @brief Decodes a Base58Check encoding over itself.
+ * @details The decoded data are written to the start of the buffer that held
+ * the encoding, which they never outgrow. The number being decoded is built
+ * up in the part of the buffer whose characters have already been consumed,
+ * so encodings of up to about 800 characters, or of any length if the library
+ * was built without GMP, are decoded with no more memory than the buffer
+ * itself and a few kilobytes of stack. Longer encodings are converted by
+ * divide and conquer, whose intermediate results need scratch space of up to
+ * about three times the size of the encoding, but the result still lands in
+ * the buffer, and no output buffer is needed.
+ * @param[in,out] buf A pointer to the Base58Check encoding to be decoded,
+ * which will be overwritten by the decoded data. Must not be @c NULL.
+ * @param n The size of the Base58Check encoding at @p buf.
+ * @param[out] n_out A pointer to a variable that will receive the size of the
+ * decoded data, not including the checksum. Must not be @c NULL.
+ * @return 0 if the encoding was valid, or else a negative number indicating
+ * that the encoding was too large (#BASE58CHECK_ESIZE) or too short
+ * (#BASE58CHECK_ELENGTH), contained an illegal character
+ * (#BASE58CHECK_ECHAR), or failed to verify (#BASE58CHECK_ECHECKSUM), or
+ * that there was a failure to allocate scratch space (#BASE58CHECK_ENOMEM).
+ * The buffer is left untouched unless the encoding was decoded before being
+ * rejected, which happens on a checksum mismatch or when an encoding not
+ * obviously too short decodes to fewer than 4 bytes; its contents are then
+ * unspecified.
+ */
+int base58check_decode_inplace(char *buf, size_t n, size_t *n_out)
+	__attribute__ ((__access__ (read_write, 1, 2), __access__ (write_only, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Encodes a batch of data items in Base58Check format.
+ * @details The encodings are written back to back, without separators, into a
+ * single output buffer. Scratch space is allocated once for the whole batch,
+ * and the checksums of a group of items are computed ahead of the group's base
+ * conversions.
+ * @param[in,out] out
+ * @parblock
+ * A pointer to the address of a buffer into which the encodings are to be
+ * written. Must not be @c NULL.
+ *
+ * If @c *out is @c NULL upon entry, then this function will allocate a
+ * suitably sized buffer by calling base58check_malloc() and will set @c *out
+ * to the address of that buffer. It is the caller's responsibility to free the
+ * allocated buffer by passing its address to base58check_free().
+ *
+ * If @c *out is not @c NULL upon entry, then this function will write the
+ * encodings to the buffer at address @c *out, which is of size given by
+ * @c *n_out and should be at least as large as the size returned by
+ * base58check_encode_batch_buffer_size().
+ * @endparblock
+ * @param[in,out] n_out
+ * @parblock
+ * If @c *out is not @c NULL upon entry, a pointer to the size of the buffer at
+ * address @c *out, or else a pointer to the minimum number of excess bytes of
+ * buffer space to allocate beyond the end of the encodings. Must not be
+ * @c NULL.
+ *
+ * Upon return, @c *n_out will be set to the combined size of the encodings,
+ * not including any excess.
+ * @endparblock
+ * @param[out] offsets A pointer to an array of <tt>n_items + 1</tt> elements
+ * that will receive the offsets of the encodings in the output buffer. The
+ * encoding of item @c i occupies the bytes from <tt>offsets[i]</tt> up to but
+ * not including <tt>offsets[i + 1]</tt>. Must not be @c NULL.
+ * @param[in] in A pointer to an array of @p n_items items describing the input
+ * data to be encoded. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @return 0 if the encoding was successful, or a negative number upon error,
+ * which may be because an item was too large, @c *n_out was too small or too
+ * large, or there was a failure to allocate memory.
+ */
+int base58check_encode_batch(char **restrict out, size_t *restrict n_out, size_t *restrict offsets, const struct base58check_item in[], size_t n_items)
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (write_only, 3), __access__ (read_only, 4, 5), __nonnull__, __nothrow__));
+
+/**
+ * @brief Returns the recommended size of a buffer to hold the decodings of the
+ * specified batch of Base58Check encodings.
+ * @param[in] in A pointer to an array of @p n_items items describing the
+ * Base58Check encodings needing to be decoded. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @param n_pad The minimum number of excess bytes to include in the returned
+ * estimate.
+ * @return An upper-bound estimate of the combined size of the decodings of the
+ * specified Base58Check encodings, or @c SIZE_MAX upon overflow.
+ */
+size_t base58check_decode_batch_buffer_size(const struct base58check_item in[], size_t n_items, size_t n_pad)
+	__attribute__ ((__access__ (read_only, 1, 2), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief Decodes a batch of data items from Base58Check format.
+ * @details The decoded data are written back to back, without separators, into
+ * a single output buffer. Scratch space is allocated once for the whole batch,
+ * and an item that fails to decode does not stop the batch; its error code is
+ * reported in @p results, and it occupies no space in the output buffer.
+ * @param[in,out] out
+ * @parblock
+ * A pointer to the address of a buffer into which the decoded data are to be
+ * written. Must not be @c NULL.
+ *
+ * If @c *out is @c NULL upon entry, then this function will allocate a
+ * suitably sized buffer by calling base58check_malloc() and will set @c *out
+ * to the address of that buffer. It is the caller's responsibility to free the
+ * allocated buffer by passing its address to base58check_free().
+ *
+ * If @c *out is not @c NULL upon entry, then this function will write the
+ * decoded data to the buffer at address @c *out, which is of size given by
+ * @c *n_out and should be at least as large as the size returned by
+ * base58check_decode_batch_buffer_size().
+ * @endparblock
+ * @param[in,out] n_out
+ * @parblock
+ * If @c *out is not @c NULL upon entry, a pointer to the size of the buffer at
+ * address @c *out, or else a pointer to the minimum number of excess bytes of
+ * buffer space to allocate beyond the end of the decoded data. Must not be
+ * @c NULL.
+ *
+ * Upon return, @c *n_out will be set to the combined size of the decoded data,
+ * not including any excess.
+ * @endparblock
+ * @param[out] offsets A pointer to an array of <tt>n_items + 1</tt> elements
+ * that will receive the offsets of the decoded data in the output buffer. The
+ * decoding of item @c i occupies the bytes from <tt>offsets[i]</tt> up to but
+ * not including <tt>offsets[i + 1]</tt>. Must not be @c NULL.
+ * @param[out] results A pointer to an array of @p n_items elements that will
+ * receive 0 for each item that was decoded successfully or else a negative
+ * error code (see base58check_decode()). Must not be @c NULL.
+ * @param[in] in A pointer to an array of @p n_items items describing the
+ * Base58Check encodings to be decoded. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @return 0 if the batch was processed, regardless of whether any individual
+ * items failed to decode, or a negative number upon error, which may be
+ * because an item was too large, @c *n_out was too small or too large
+ * (#BASE58CHECK_ESIZE), or there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM).
+ */
+int base58check_decode_batch(unsigned char **restrict out, size_t *restrict n_out, size_t *restrict offsets, int *restrict results, const struct base58check_item in[], size_t n_items)
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (write_only, 3), __access__ (write_only, 4, 6), __access__ (read_only, 5, 6), __nonnull__, __nothrow__));
+
+/**
+ * @brief An opaque codec context that owns reusable scratch space.
+ * @details A context holds growable limb scratch space and a prefetched SHA-256
+ * digest, so that once its scratch space has grown to fit the largest input
+ * seen, encoding or decoding into a caller-supplied buffer performs no memory
+ * allocations. A context must not be used by more than one thread at a time.
+ */
+struct base58check_ctx;
+
+/**
+ * @brief Frees a codec context.
+ * @param ctx A pointer to the context to be freed. Must have been previously
+ * returned by base58check_ctx_new() or base58check_ctx_new_with_allocator()
+ * and must not be @c NULL.
+ */
+void base58check_ctx_free(struct base58check_ctx *ctx)
+	__attribute__ ((__nonnull__, __nothrow__));
+
+/**
+ * @brief Allocates a new codec context.
+ * @return A pointer to the new context, or @c NULL if memory could not be
+ * allocated. If not @c NULL, this pointer must be passed to
+ * base58check_ctx_free() to free the context.
+ */
+struct base58check_ctx * base58check_ctx_new(void)
+	__attribute__ ((__malloc__, __malloc__ (base58check_ctx_free, 1), __nothrow__));
+
+/**
+ * @brief A memory allocator that a codec context uses in place of
+ * base58check_malloc() and base58check_free().
+ * @details The one exception is the table of powers of 58 that conversions of
+ * large numbers share, which lives for the life of the process and so is
+ * never tied to a context. Its entries are allocated through
+ * base58check_malloc() on first use.
+ */
+struct base58check_allocator {
+	/**
+	 * @brief Allocates memory.
+	 * @param opaque The allocator's @c opaque pointer.
+	 * @param size The size of the requested allocation, never 0.
+	 * @return A pointer to memory suitably aligned for any object type, or
+	 * @c NULL if the allocation could not be provided.
+	 */
+	void * (*alloc)(void *opaque, size_t size);
+	/**
+	 * @brief Frees memory returned by @c alloc.
+	 * @param opaque The allocator's @c opaque pointer.
+	 * @param ptr A pointer previously returned by @c alloc. Never @c NULL.
+	 * @param size The size that was passed to @c alloc for @p ptr.
+	 */
+	void (*free)(void *opaque, void *ptr, size_t size);
+	/** @brief User data passed through to @c alloc and @c free. */
+	void *opaque;
+};
+
+/**
+ * @brief Allocates a new codec context that takes its memory from the
+ * specified allocator.
+ * @details The context itself, its scratch space, and any output buffer that
+ * a function allocates when passed the context, are all allocated through
+ * @p allocator, so a caller can tie every allocation of a call to a
+ * per-request arena, say, by creating a context for the request. Such a
+ * context hashes without OpenSSL's digest objects, which would be allocated
+ * elsewhere. The one allocation not tied to a context is the process-lifetime
+ * table of powers of 58 described at #base58check_allocator, which the first
+ * conversion of a large number fills through base58check_malloc().
+ * @note The size of an output buffer that is allocated for the caller is not
+ * reported back, so an allocator whose @c free needs the size should be used
+ * with caller-supplied output buffers only.
+ * @param[in] allocator A pointer to the allocator to use. Must not be
+ * @c NULL. The allocator is copied.
+ * @return A pointer to the new context, or @c NULL if memory could not be
+ * allocated. If not @c NULL, this pointer must be passed to
+ * base58check_ctx_free() to free the context, which returns its memory to the
+ * allocator.
+ */
+struct base58check_ctx * base58check_ctx_new_with_allocator(const struct base58check_allocator *allocator)
+	__attribute__ ((__access__ (read_only, 1), __malloc__, __malloc__ (base58check_ctx_free, 1), __nonnull__, __nothrow__));
+
+/**
+ * @brief Encodes data in Base58Check format using a codec context.
+ * @details This function behaves exactly like base58check_encode() except that
+ * its scratch space comes from @p ctx.
+ * @param ctx A pointer to the context to use. Must not be @c NULL.
+ * @param[in,out] out See base58check_encode().
+ * @param[in,out] n_out See base58check_encode().
+ * @param[in] in See base58check_encode().
+ * @param n_in See base58check_encode().
+ * @param n_hdr See base58check_encode().
+ * @return See base58check_encode().
+ */
+int base58check_encode_ctx(struct base58check_ctx *restrict ctx, char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr)
+	__attribute__ ((__access__ (read_write, 2), __access__ (read_write, 3), __access__ (read_only, 4), __nonnull__, __nothrow__));
+
+/**
+ * @brief Decodes data from Base58Check format using a codec context.
+ * @details This function behaves exactly like base58check_decode() except that
+ * its scratch space comes from @p ctx.
+ * @param ctx A pointer to the context to use. Must not be @c NULL.
+ * @param[in,out] out See base58check_decode().
+ * @param[in,out] n_out See base58check_decode().
+ * @param[in] in See base58check_decode().
+ * @param n_in See base58check_decode().
+ * @param n_hdr See base58check_decode().
+ * @return See base58check_decode().
+ */
+int base58check_decode_ctx(struct base58check_ctx *restrict ctx, unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr)
+	__attribute__ ((__access__ (read_write, 2), __access__ (read_write, 3), __access__ (read_only, 4), __nonnull__, __nothrow__));
+
+/**
+ * @brief Encodes data in Base58Check or plain Base58 format, optionally using
+ * a codec context.
+ * @details This function behaves exactly like base58check_encode_ctx() except
+ * that @p ctx may be @c NULL and that #BASE58CHECK_RAW in @p flags selects
+ * plain Base58.
+ * @param ctx A pointer to the context to use, or @c NULL to use temporary
+ * scratch space.
+ * @param[in,out] out See base58check_encode().
+ * @param[in,out] n_out See base58check_encode().
+ * @param[in] in See base58check_encode().
+ * @param n_in See base58check_encode().
+ * @param n_hdr See base58check_encode().
+ * @param flags A bitwise OR of zero or more #base58check_flags.
+ * @return See base58check_encode().
+ */
+int base58check_encode_ex(struct base58check_ctx *restrict ctx, char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr, unsigned flags)
+	__attribute__ ((__access__ (read_write, 2), __access__ (read_write, 3), __access__ (read_only, 4), __nonnull__ (2, 3, 4), __nothrow__));
+
+/**
+ * @brief Decodes data from Base58Check or plain Base58 format, optionally
+ * using a codec context.
+ * @details This function behaves exactly like base58check_decode_ctx() except
+ * that @p ctx may be @c NULL, that #BASE58CHECK_RAW in @p flags selects plain
+ * Base58, and that #BASE58CHECK_TRUSTED in @p flags skips the verification of
+ * the checksum, leaving only the base conversion.
+ * @param ctx A pointer to the context to use, or @c NULL to use temporary
+ * scratch space.
+ * @param[in,out] out See base58check_decode().
+ * @param[in,out] n_out See base58check_decode().
+ * @param[in] in See base58check_decode().
+ * @param n_in See base58check_decode().
+ * @param n_hdr See base58check_decode().
+ * @param flags A bitwise OR of zero or more #base58check_flags.
+ * @return See base58check_decode().
+ */
+int base58check_decode_ex(struct base58check_ctx *restrict ctx, unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr, unsigned flags)
+	__attribute__ ((__access__ (read_write, 2), __access__ (read_write, 3), __access__ (read_only, 4), __nonnull__ (2, 3, 4), __nothrow__));
+
+/**
+ * @brief An opaque encoder for payloads that all begin with the same prefix.
+ * @details An encoder holds the state of SHA-256 after absorbing its prefix
+ * and, for tails of the size given at construction, the contribution of the
+ * prefix to the value of the payload, precomputed in the output base. Each
+ * encoding then hashes and converts only the tail. An encoder is not modified
+ * by encoding and so may be shared between threads.
+ */
+struct base58check_prefix_encoder;
+
+/**
+ * @brief Frees a prefix encoder.
+ * @param enc A pointer to the encoder to be freed. Must have been previously
+ * returned by base58check_prefix_encoder_new() and must not be @c NULL.
+ */
+void base58check_prefix_encoder_free(struct base58check_prefix_encoder *enc)
+	__attribute__ ((__nonnull__, __nothrow__));
+
+/**
+ * @brief Allocates a new prefix encoder.
+ * @param[in] prefix A pointer to the prefix that begins every payload to be
+ * encoded, such as a version byte. Must not be @c NULL. The prefix is copied.
+ * @param n_prefix The number of bytes of prefix at @p prefix.
+ * @param n_tail The size of the tails that will usually follow the prefix.
+ * Tails of other sizes can be encoded too, but without the benefit of the
+ * precomputed prefix contribution.
+ * @return A pointer to the new encoder, or @c NULL if memory could not be
+ * allocated or the sizes were too large. If not @c NULL, this pointer must be
+ * passed to base58check_prefix_encoder_free() to free the encoder.
+ */
+struct base58check_prefix_encoder * base58check_prefix_encoder_new(const unsigned char *prefix, size_t n_prefix, size_t n_tail)
+	__attribute__ ((__access__ (read_only, 1, 2), __malloc__, __malloc__ (base58check_prefix_encoder_free, 1), __nonnull__, __nothrow__));
+
+/**
+ * @brief Returns the recommended size of a buffer to hold the Base58Check
+ * encoding of a prefix encoder's prefix followed by the specified tail.
+ * @param enc A pointer to the encoder. Must not be @c NULL.
+ * @param[in] tail A pointer to the tail. Must not be @c NULL.
+ * @param n_tail The number of bytes of tail at @p tail.
+ * @param n_pad The minimum number of excess bytes to include in the returned
+ * estimate.
+ * @return An upper-bound estimate of the size of the encoding, or @c SIZE_MAX
+ * upon overflow.
+ */
+size_t base58check_prefix_encode_buffer_size(const struct base58check_prefix_encoder *enc, const unsigned char *tail, size_t n_tail, size_t n_pad)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_only, 2), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief Encodes a prefix encoder's prefix followed by the specified tail in
+ * Base58Check format.
+ * @details The encoding is the same as that produced by base58check_encode()
+ * on the concatenation of the prefix and the tail.
+ * @param enc A pointer to the encoder. Must not be @c NULL.
+ * @param[in,out] out See base58check_encode().
+ * @param[in,out] n_out See base58check_encode().
+ * @param[in] tail A pointer to the tail to be encoded. Must not be @c NULL.
+ * @param n_tail The number of bytes of tail at @p tail.
+ * @param n_hdr See base58check_encode().
+ * @return See base58check_encode().
+ */
+int base58check_prefix_encode(const struct base58check_prefix_encoder *restrict enc, char **restrict out, size_t *n_out, const unsigned char *restrict tail, size_t n_tail, size_t n_hdr)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_write, 2), __access__ (read_write, 3), __access__ (read_only, 4), __nonnull__, __nothrow__));
+
+/**
+ * @brief Generates a candidate payload for base58check_search_prefix().
+ * @details Called concurrently from all of the search threads, so it must be
+ * thread-safe. Each index is generated once.
+ * @param opaque The search's @c opaque pointer.
+ * @param index The number of the candidate, counting from zero.
+ * @param[out] payload A pointer to a buffer that is to receive the payload.
+ * @param n_payload The size of the payload.
+ */
+typedef void base58check_candidate_fn(void *opaque, uint64_t index, unsigned char *payload, size_t n_payload);
+
+/**
+ * @brief Receives a match found by base58check_search_prefix().
+ * @details Called from one search thread at a time.
+ * @param opaque The search's @c opaque pointer.
+ * @param[in] payload A pointer to the matching payload.
+ * @param n_payload The size of the payload.
+ * @param[in] encoding A pointer to the Base58Check encoding of the payload,
+ * which begins with the searched-for prefix.
+ * @param n_encoding The size of the encoding.
+ * @return 0 to continue searching, or nonzero to stop.
+ */
+typedef int base58check_match_fn(void *opaque, const unsigned char *payload, size_t n_payload, const char *encoding, size_t n_encoding);
+
+/**
+ * @brief Describes a search for payloads whose encodings begin with a prefix.
+ */
+struct base58check_search {
+	/** @brief A pointer to the characters with which encodings must begin. */
+	const char *prefix;
+	/** @brief The number of characters at @c prefix. */
+	size_t n_prefix;
+	/** @brief The size of each candidate payload. */
+	size_t n_payload;
+	/** @brief A pointer to the fixed bytes, such as a version, with which the
+	 * built-in generator begins each candidate. Ignored if @c candidate is
+	 * not @c NULL. */
+	const unsigned char *head;
+	/** @brief The number of bytes at @c head. */
+	size_t n_head;
+	/** @brief The seed from which the built-in generator derives the bytes
+	 * that follow the head, which are pseudorandom but not unpredictable. */
+	uint64_t seed;
+	/** @brief A function that generates candidates, or @c NULL to use the
+	 * built-in generator. */
+	base58check_candidate_fn *candidate;
+	/** @brief A function that receives matches. Must not be @c NULL. */
+	base58check_match_fn *match;
+	/** @brief User data passed through to @c candidate and @c match. */
+	void *opaque;
+	/** @brief The number of matches after which to stop, or 0 for no
+	 * limit. */
+	uint64_t max_matches;
+	/** @brief The number of candidates after which to stop, or 0 for no
+	 * limit. */
+	uint64_t max_candidates;
+	/** @brief The number of threads to search in, or 0 for one per online
+	 * CPU. */
+	unsigned n_threads;
+};
+
+/**
+ * @brief Figures describing a finished search.
+ */
+struct base58check_search_stats {
+	/** @brief The number of candidates examined. */
+	uint64_t candidates;
+	/** @brief The number of candidates whose checksums had to be computed
+	 * to decide them. */
+	uint64_t checksums;
+	/** @brief The number of matches passed to the @c match function. */
+	uint64_t matches;
+	/** @brief The wall-clock duration of the search in seconds. */
+	double seconds;
+};
+
+/**
+ * @brief Searches for payloads whose Base58Check encodings begin with a
+ * prefix.
+ * @details The prefix is translated up front into the ranges of values that
+ * payloads of the given size must take for their encodings to begin with it,
+ * so most candidates are rejected by comparing their leading bytes against
+ * those ranges, with no base conversion and no hash. Only a candidate that
+ * falls on the edge of a range has its checksum computed, and only a match is
+ * encoded. Threads claim blocks of consecutive candidate indices from a
+ * shared counter until the search stops, which it does when @c max_matches
+ * matches have been found, the @c match function returns nonzero, or
+ * @c max_candidates candidates have been examined, whichever comes first.
+ * Matches that other threads find after that are discarded.
+ * @param[in] search A pointer to the description of the search. Must not be
+ * @c NULL.
+ * @param[out] stats A pointer to a structure that will receive figures
+ * describing the search, or @c NULL.
+ * @return 0 if the search ran until it stopped, or else a negative error code:
+ * the prefix contained an illegal character (#BASE58CHECK_ECHAR), no encoding
+ * of a payload of the given size, or with the given head, can begin with the
+ * prefix, or the prefix has more leading '1' characters than the payload has
+ * bytes (#BASE58CHECK_ELENGTH), the head was longer than the payload
+ * (#BASE58CHECK_ESIZE), or there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM). If threads cannot be started, the search runs in
+ * fewer of them.
+ */
+int base58check_search_prefix(const struct base58check_search *search, struct base58check_search_stats *stats)
+	__attribute__ ((__access__ (read_only, 1), __access__ (write_only, 2), __nonnull__ (1), __nothrow__));
+
+/**
+ * @brief The number of buckets of a latency histogram in
+ * #base58check_op_stats.
+ */
+#define BASE58CHECK_STATS_BUCKETS 32
+
+/**
+ * @brief One more than the magnitude of the least #base58check_error, and so
+ * the number of failure counters in #base58check_op_stats.
+ */
+#define BASE58CHECK_STATS_ERRORS 10
+
+/**
+ * @brief Statistics of the calls of one operation.
+ */
+struct base58check_op_stats {
+	/** @brief The number of calls made. */
+	uint64_t calls;
+	/** @brief The number of bytes of input passed to the calls. */
+	uint64_t bytes_in;
+	/** @brief The number of bytes of output produced by the calls that
+	 * succeeded, not including any header bytes. */
+	uint64_t bytes_out;
+	/** @brief The number of calls that returned each error code, indexed by
+	 * its negation. Element 0 is unused. */
+	uint64_t failures[BASE58CHECK_STATS_ERRORS];
+	/** @brief A histogram of the wall-clock durations of the calls. Element
+	 * @c i counts the calls that took less than 2<sup>@c i</sup> but at least
+	 * 2<sup>@c i-1</sup> nanoseconds, except that the last element counts all
+	 * longer calls as well. */
+	uint64_t latency[BASE58CHECK_STATS_BUCKETS];
+};
+
+/**
+ * @brief Statistics of the calls made into the library.
+ * @details Encoding counts the calls of base58check_encode_ex() and of the
+ * functions that wrap it: base58check_encode(), base58check_encode_ctx(), and
+ * base58_encode(). Decoding likewise counts the calls of
+ * base58check_decode_ex() and its wrappers, and of
+ * base58check_decode_inplace().
+ */
+struct base58check_stats {
+	/** @brief Statistics of encoding. */
+	struct base58check_op_stats encode;
+	/** @brief Statistics of decoding. */
+	struct base58check_op_stats decode;
+};
+
+/**
+ * @brief Takes a snapshot of the statistics that the library has gathered
+ * since it was loaded.
+ * @details Statistics are gathered only if the library was configured with
+ * <tt>--enable-stats</tt>. Each thread then counts its own calls, with no
+ * synchronization, and the snapshot sums the counts of all threads, including
+ * those that have exited. A snapshot taken while other threads are making
+ * calls may miss their latest calls or count a call in some of its figures but
+ * not yet in others. The same build fires USDT probes that tools such as
+ * bpftrace can attach to, if @c <sys/sdt.h> was available:
+ * @c base58check:encode__entry and @c base58check:decode__entry receive the
+ * input pointer and size and the flags; @c base58check:encode__return and
+ * @c base58check:decode__return receive the return value, the output size,
+ * and the duration of the call in nanoseconds.
+ * @param[out] stats A pointer to a structure that will receive the
+ * statistics. Must not be @c NULL.
+ * @return 0 if the snapshot was taken, or #BASE58CHECK_ENOTSUP if the library
+ * gathers no statistics, in which case @p stats is zeroed.
+ */
+int base58check_stats_snapshot(struct base58check_stats *stats)
+	__attribute__ ((__access__ (write_only, 1), __nonnull__, __nothrow__));
+
+/**
+ * @brief The largest payload that an address set can hold.
+ */
+#define BASE58CHECK_SET_MAX_PAYLOAD 252
+
+/**
+ * @brief A set of decoded payloads of one fixed size, such as a list of
+ * addresses.
+ * @details The set is an open-addressing hash table whose slots are laid out
+ * as a self-contained image: a 64-byte header, then a 32-bit tag per slot,
+ * then the payloads themselves. The table is at least a quarter empty, so a
+ * probe for a payload that is absent usually ends in the first cache line of
+ * tags it touches, and payloads are compared only on a tag match. All of the
+ * image's fields are stored little-endian, so the image can be saved to a
+ * file on one machine and mapped read-only on another, then shared by any
+ * number of processes with no loading. The members of this structure are
+ * private.
+ */
+struct base58check_set {
+	const unsigned char *image;
+	size_t n_image, n_payload, n_items, n_slots;
+	uint64_t seed;
+	int owner;
+};
+
+/**
+ * @brief Builds an address set from Base58Check encodings.
+ * @details The encodings are decoded and verified in batches with
+ * base58check_decode_batch(). Duplicates are stored once.
+ * @param[out] set A pointer to the set to be built, which must be freed with
+ * base58check_set_free() if this function succeeds. Must not be @c NULL.
+ * @param[in] in A pointer to an array of @p n_items items describing the
+ * Base58Check encodings to be added. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @param n_payload The size of each decoded payload, not including the
+ * checksum. Must be from 1 to #BASE58CHECK_SET_MAX_PAYLOAD.
+ * @param[out] results A pointer to an array of @p n_items elements that will
+ * receive 0 for each item that was added or else a negative error code (see
+ * base58check_decode()), which is #BASE58CHECK_ELENGTH for an item that did
+ * not decode to @p n_payload bytes. Invalid items are then skipped. May be
+ * @c NULL, in which case any invalid item fails the whole build.
+ * @return 0 if the set was built, or else a negative number indicating that
+ * @p n_payload or the set was too large (#BASE58CHECK_ESIZE), there was a
+ * failure to allocate memory (#BASE58CHECK_ENOMEM), or, if @p results is
+ * @c NULL, the error code of the first invalid item.
+ */
+int base58check_set_build(struct base58check_set *restrict set, const struct base58check_item in[], size_t n_items, size_t n_payload, int results[])
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __access__ (write_only, 5, 3), __nonnull__ (1, 2), __nothrow__));
+
+/**
+ * @brief Opens an address set over an image in memory.
+ * @details Only the header is examined, so this takes constant time. The
+ * image is not copied and must outlive the set.
+ * @param[out] set A pointer to the set to be opened. Must not be @c NULL.
+ * @param[in] image A pointer to the image, as saved by base58check_set_save().
+ * Need not be aligned. Must not be @c NULL.
+ * @param n_image The size of the image.
+ * @return 0 if the set was opened, or #BASE58CHECK_EFORMAT if the image was
+ * not that of an address set.
+ */
+int base58check_set_open(struct base58check_set *restrict set, const void *image, size_t n_image)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Maps an address set read-only from a file.
+ * @details The file is mapped shared, so all of the processes that map it
+ * share a single copy in the page cache, and the mapping is advised for
+ * random access. Nothing is read until lookups touch it.
+ * @param[out] set A pointer to the set to be opened, which must be freed with
+ * base58check_set_free() if this function succeeds. Must not be @c NULL.
+ * @param[in] path The path of the file. Must not be @c NULL.
+ * @return 0 if the set was mapped, or else a negative number indicating that
+ * the file could not be opened or mapped (#BASE58CHECK_EIO) or did not hold
+ * an address set (#BASE58CHECK_EFORMAT).
+ */
+int base58check_set_map(struct base58check_set *restrict set, const char *restrict path)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2), __nonnull__, __nothrow__));
+
+/**
+ * @brief Saves the image of an address set to a file.
+ * @details The image is written to a temporary file beside the destination,
+ * which is then renamed over it, so processes that have an older version of
+ * the file mapped keep seeing the old set rather than a torn one.
+ * @param[in] set A pointer to the set to be saved. Must not be @c NULL.
+ * @param[in] path The path of the file. Must not be @c NULL.
+ * @return 0 if the set was saved, or else a negative number indicating that
+ * the file could not be written (#BASE58CHECK_EIO) or there was a failure to
+ * allocate memory (#BASE58CHECK_ENOMEM).
+ */
+int base58check_set_save(const struct base58check_set *restrict set, const char *restrict path)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_only, 2), __nonnull__, __nothrow__));
+
+/**
+ * @brief Frees the memory or mapping held by an address set.
+ * @param[in,out] set A pointer to the set to be freed, which may have been
+ * built, opened, or mapped. Must not be @c NULL.
+ */
+void base58check_set_free(struct base58check_set *set)
+	__attribute__ ((__nonnull__, __nothrow__));
+
+/**
+ * @brief Looks up a Base58Check encoding in an address set.
+ * @details The encoding is verified with base58check_decode_expect(), which
+ * needs no memory beyond the stack, before its payload is looked up.
+ * @param[in] set A pointer to the set. Must not be @c NULL.
+ * @param[in] in A pointer to the Base58Check encoding. Must not be @c NULL.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @return 1 if the payload of the encoding is in the set, 0 if it is not, or a
+ * negative error code if the encoding is not valid or does not decode to a
+ * payload of the set's size (see base58check_decode_expect()).
+ */
+int base58check_set_contains(const struct base58check_set *restrict set, const char *restrict in, size_t n_in)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief Looks up a decoded payload in an address set.
+ * @param[in] set A pointer to the set. Must not be @c NULL.
+ * @param[in] payload A pointer to the payload, not including any checksum.
+ * Must not be @c NULL.
+ * @param n_payload The size of the payload at @p payload.
+ * @return 1 if the payload is in the set, or 0 if it is not, which is always
+ * the case if @p n_payload is not the set's payload size.
+ */
+int base58check_set_contains_payload(const struct base58check_set *restrict set, const unsigned char *restrict payload, size_t n_payload)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief A packed corpus of decoded payloads.
+ * @details A pack is a self-contained image: a 64-byte header, then the
+ * records, then an optional index. If every payload is of the same nonzero
+ * size, the records are the payloads back to back; otherwise each payload is
+ * prefixed by its size as an unsigned LEB128 number, and the index, if
+ * present, holds the offset of each record and then the end of the records,
+ * each as a little-endian 64-bit word. Checksums are verified when a pack is
+ * made and are not stored, so a pack takes less than three quarters of the
+ * space of the encodings that it holds (about 60% for P2PKH addresses), and
+ * it can be mapped and used as it is, with no parsing. The members of this
+ * structure are private.
+ */
+struct base58check_pack {
+	const unsigned char *image, *records, *index;
+	size_t n_image, n_records, record_size, n_bytes;
+	unsigned flags;
+};
+
+/**
+ * @brief Returns the recommended size of a buffer to hold a pack of a batch
+ * of Base58Check encodings.
+ * @param[in] in A pointer to an array of @p n_items items describing the
+ * Base58Check encodings. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @param flags See base58check_pack_batch().
+ * @return The recommended buffer size, or @c SIZE_MAX if the pack would be
+ * too large.
+ */
+size_t base58check_pack_batch_buffer_size(const struct base58check_item in[], size_t n_items, unsigned flags)
+	__attribute__ ((__access__ (read_only, 1, 2), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief Packs a batch of Base58Check encodings.
+ * @details The encodings are decoded and verified with
+ * base58check_decode_batch(), straight into the buffer of the pack, and
+ * payloads of varying sizes are then spread out in place to make room for
+ * their size prefixes.
+ * @param[in,out] out See base58check_decode_batch(), substituting
+ * base58check_pack_batch_buffer_size() for base58check_decode_batch_buffer_size().
+ * @param[in,out] n_out See base58check_decode_batch(). Upon return, @c *n_out
+ * will be set to the size of the pack.
+ * @param[in] in A pointer to an array of @p n_items items describing the
+ * Base58Check encodings to be packed. Must not be @c NULL.
+ * @param n_items The number of items at @p in.
+ * @param flags #BASE58CHECK_PACK_INDEX to write an index, which packs of
+ * fixed-size records never need and so never have, or 0.
+ * @param[out] results A pointer to an array of @p n_items elements that will
+ * receive 0 for each item that was packed or else a negative error code (see
+ * base58check_decode()). Invalid items are then skipped. May be @c NULL, in
+ * which case any invalid item fails the whole pack.
+ * @return 0 if the pack was made, or else a negative number indicating that
+ * an item was too large, @c *n_out was too small or too large
+ * (#BASE58CHECK_ESIZE), there was a failure to allocate memory
+ * (#BASE58CHECK_ENOMEM), or, if @p results is @c NULL, the error code of the
+ * first invalid item.
+ */
+int base58check_pack_batch(unsigned char **restrict out, size_t *restrict n_out, const struct base58check_item in[], size_t n_items, unsigned flags, int results[])
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3, 4), __access__ (write_only, 6, 4), __nonnull__ (1, 2, 3), __nothrow__));
+
+/**
+ * @brief Opens a pack over an image in memory, such as a mapped file.
+ * @details Only the header is examined, so this takes constant time. The
+ * image is not copied and must outlive the pack.
+ * @param[out] pack A pointer to the pack to be opened. Must not be @c NULL.
+ * @param[in] image A pointer to the image, as made by
+ * base58check_pack_batch(). Must not be @c NULL.
+ * @param n_image The size of the image.
+ * @return 0 if the pack was opened, or #BASE58CHECK_EFORMAT if the image was
+ * not that of a pack.
+ */
+int base58check_pack_open(struct base58check_pack *restrict pack, const void *image, size_t n_image)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__));
+
+/**
+ * @brief Finds a record of a pack.
+ * @details Takes constant time if the records are of a fixed size or the pack
+ * has an index, and otherwise scans the records that precede it.
+ * @param[in] pack A pointer to the pack. Must not be @c NULL.
+ * @param i The number of the record, counting from zero.
+ * @param[out] payload A pointer to a variable that will receive a pointer to
+ * the payload of the record, within the image. Must not be @c NULL.
+ * @param[out] n_payload A pointer to a variable that will receive the size of
+ * the payload. Must not be @c NULL.
+ * @return 0 if the record was found, or else a negative number indicating
+ * that there is no record @p i (#BASE58CHECK_ESIZE) or that the pack is
+ * corrupt (#BASE58CHECK_EFORMAT).
+ */
+int base58check_pack_record(const struct base58check_pack *restrict pack, size_t i, const unsigned char **restrict payload, size_t *restrict n_payload)
+	__attribute__ ((__access__ (read_only, 1), __access__ (write_only, 3), __access__ (write_only, 4), __nonnull__, __nothrow__));
+
+/**
+ * @brief Returns the recommended size of a buffer to hold the unpacked
+ * encodings of a pack.
+ * @details Takes time in proportion to the number of records if they are of
+ * varying sizes.
+ * @param[in] pack A pointer to the pack. Must not be @c NULL.
+ * @return The recommended buffer size, or @c SIZE_MAX if the encodings would
+ * be too large or the pack is corrupt.
+ */
+size_t base58check_unpack_buffer_size(const struct base58check_pack *pack)
+	__attribute__ ((__access__ (read_only, 1), __nonnull__, __nothrow__, __pure__));
+
+/**
+ * @brief Encodes the records of a pack in Base58Check format, each followed
+ * by a newline.
+ * @details The records are cut into runs, which threads claim from a shared
+ * counter and encode with base58check_encode_batch() into their own parts of
+ * the output buffer, each part sized for the longest encodings that its run
+ * could have. The parts are then closed up in order.
+ * @param[in,out] out See base58check_encode_batch(), substituting
+ * base58check_unpack_buffer_size() for base58check_encode_batch_buffer_size().
+ * @param[in,out] n_out See base58check_encode_batch(). Upon return, @c *n_out
+ * will be set to the size of the encodings, including their newlines.
+ * @param[in] pack A pointer to the pack. Must not be @c NULL.
+ * @param n_threads The number of threads to encode in, or 0 for one per
+ * online CPU.
+ * @return 0 if the pack was unpacked, or else a negative number indicating
+ * that the encodings would be too large, @c *n_out was too small or too large
+ * (#BASE58CHECK_ESIZE), the pack is corrupt (#BASE58CHECK_EFORMAT), or there
+ * was a failure to allocate memory (#BASE58CHECK_ENOMEM). If threads cannot
+ * be started, the encoding is done in fewer of them.
+ */
+int base58check_unpack(char **restrict out, size_t *restrict n_out, const struct base58check_pack *restrict pack, unsigned n_threads)
+	__attribute__ ((__access__ (read_write, 1), __access__ (read_write, 2), __access__ (read_only, 3), __nonnull__, __nothrow__));
+
 
 /**
  * @brief Frees memory allocated by base58check_malloc().
@@ -149,10 +1125,21 @@ void * base58check_malloc(size_t size)
 #include <string>
 #include <vector>
 #if __cplusplus >= 201103L
+# include <cerrno>
+# include <new>
+# include <system_error>
 # include <type_traits>
+# include <utility>
 # if __cplusplus >= 201703L
+#  include <array>
+#  if __has_include(<memory_resource>)
+#   include <memory_resource>
+#  endif
+#  include <cstdint>
 #  include <string_view>
 #  if __cplusplus >= 202002L
+#   include <iterator>
+#   include <ranges>
 #   include <span>
 #  endif
 # endif
@@ -186,6 +1173,19 @@ encode(const byte (&in)[N_in], size_t n_hdr = 0) {
 	return ::base58check::encode(in, N_in, n_hdr);
 }
 
+static inline std::string
+encode(const ::base58check_item in[], size_t n_items, std::vector<size_t> &offsets) {
+	std::string ret;
+	ret.resize(::base58check_encode_batch_buffer_size(in, n_items, 0));
+	offsets.resize(n_items + 1);
+	char *out = &ret[0];
+	size_t n_out = ret.size();
+	if (::base58check_encode_batch(&out, &n_out, offsets.data(), in, n_items) < 0)
+		throw std::length_error("Base58Check encoding is too large");
+	ret.resize(n_out);
+	return ret;
+}
+
 static inline std::vector<byte>
 __attribute__ ((__pure__))
 decode(const char in[], size_t n_in, size_t n_hdr = 0) {
@@ -199,16 +1199,596 @@ decode(const char in[], size_t n_in, size_t n_hdr = 0) {
 	return ret;
 }
 
-#if __cplusplus >= 201103L
+static inline bool
+__attribute__ ((__pure__))
+is_valid(const char in[], size_t n_in) {
+	return ::base58check_verify(in, n_in, NULL) == 0;
+}
 
-#if __cpp_concepts >= 201907L
-template <typename T> requires std::is_trivially_copyable_v<T>
-#else
-template <typename T, typename std::enable_if<std::is_trivially_copyable<T>::value, bool>::type = true>
-#endif
 static inline std::string
 __attribute__ ((__pure__))
-encode(const T in[], size_t n_in, size_t n_hdr = 0) {
+encode_raw(const byte in[], size_t n_in, size_t n_hdr = 0) {
+	std::string ret;
+	ret.resize(::base58_encode_buffer_size(reinterpret_cast<const unsigned char *>(in), n_in, n_hdr + 1)); // never empty
+	char *out = &ret.front();
+	size_t n_out = ret.size();
+	if (::base58_encode(&out, &n_out, reinterpret_cast<const unsigned char *>(in), n_in, n_hdr) < 0)
+		throw std::length_error("Base58 encoding is too large");
+	ret.resize(n_out);
+	return ret;
+}
+
+static inline std::vector<byte>
+__attribute__ ((__pure__))
+decode_raw(const char in[], size_t n_in, size_t n_hdr = 0) {
+	std::vector<byte> ret;
+	ret.resize(::base58check_decode_buffer_size(in, n_in, n_hdr + 1)); // never empty, so data() is not null
+	unsigned char *out = reinterpret_cast<unsigned char *>(ret.data());
+	size_t n_out = ret.size();
+	if (::base58_decode(&out, &n_out, in, n_in, n_hdr) < 0)
+		throw std::invalid_argument("not a valid Base58 encoding");
+	ret.resize(n_out);
+	return ret;
+}
+
+static inline std::vector<byte>
+__attribute__ ((__pure__))
+decode_trusted(const char in[], size_t n_in, size_t n_hdr = 0) {
+	std::vector<byte> ret;
+	ret.resize(::base58check_decode_buffer_size(in, n_in, n_hdr));
+	unsigned char *out = reinterpret_cast<unsigned char *>(ret.data());
+	size_t n_out = ret.size();
+	if (::base58check_decode_ex(NULL, &out, &n_out, in, n_in, n_hdr, BASE58CHECK_TRUSTED) < 0)
+		throw std::invalid_argument("not a valid Base58Check encoding");
+	ret.resize(n_out);
+	return ret;
+}
+
+static inline std::vector<byte>
+decode(const ::base58check_item in[], size_t n_items, std::vector<size_t> &offsets, std::vector<int> &results) {
+	std::vector<byte> ret;
+	ret.resize(::base58check_decode_batch_buffer_size(in, n_items, 1)); // never empty, so data() is not null
+	offsets.resize(n_items + 1);
+	results.resize(n_items);
+	unsigned char *out = reinterpret_cast<unsigned char *>(ret.data());
+	size_t n_out = ret.size();
+	if (::base58check_decode_batch(&out, &n_out, offsets.data(), results.data(), in, n_items) < 0)
+		throw std::length_error("Base58Check batch is too large");
+	ret.resize(n_out);
+	return ret;
+}
+
+#if __cplusplus >= 201103L
+
+/**
+ * @brief Decodes a Base58Check encoding over itself.
+ * @details See base58check_decode_inplace(). The string's storage is reused
+ * for the decoded data, which are handed back in it, not including the
+ * checksum.
+ */
+static inline std::string
+decode_inplace(std::string &&in) {
+	size_t n_out;
+	int ret = ::base58check_decode_inplace(&in[0], in.size(), &n_out);
+	if (ret == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (ret < 0)
+		throw std::invalid_argument("not a valid Base58Check encoding");
+	in.resize(n_out);
+	return std::move(in);
+}
+
+/**
+ * @brief A compact set of decoded payloads of one size, such as a denylist of
+ * addresses.
+ * @details See #base58check_set. A set is built from encodings, mapped from a
+ * file written by save(), or opened over an image in memory. Sets are movable
+ * but not copyable.
+ */
+class address_set {
+	::base58check_set set_ { };
+
+	address_set() noexcept = default;
+
+	static void check(int ret, const char *path = nullptr) {
+		switch (ret) {
+			case 0:
+				return;
+			case BASE58CHECK_ENOMEM:
+				throw std::bad_alloc();
+			case BASE58CHECK_ESIZE:
+				throw std::length_error("address set is too large");
+			case BASE58CHECK_EIO:
+				throw std::system_error(errno, std::generic_category(), path);
+			case BASE58CHECK_EFORMAT:
+				throw std::invalid_argument("not an address set");
+			default:
+				throw std::invalid_argument("not a valid Base58Check encoding");
+		}
+	}
+
+public:
+	/**
+	 * @brief Builds a set from Base58Check encodings.
+	 * @throws std::invalid_argument if any encoding is not valid or does not
+	 * decode to @p payload_size bytes.
+	 */
+	address_set(const ::base58check_item in[], size_t n_items, size_t payload_size) {
+		check(::base58check_set_build(&set_, in, n_items, payload_size, nullptr));
+	}
+
+	/**
+	 * @brief Builds a set from a range of strings of Base58Check encodings.
+	 * @throws std::invalid_argument if any encoding is not valid or does not
+	 * decode to @p payload_size bytes.
+	 */
+	template <typename Range>
+	address_set(const Range &addresses, size_t payload_size) {
+		std::vector<::base58check_item> items;
+		for (const auto &address : addresses) {
+			::base58check_item item;
+			item.data = address.data(), item.size = address.size();
+			items.push_back(item);
+		}
+		check(::base58check_set_build(&set_, items.data(), items.size(), payload_size, nullptr));
+	}
+
+	address_set(address_set &&other) noexcept : set_(other.set_) {
+		other.set_ = ::base58check_set { };
+	}
+
+	address_set & operator=(address_set &&other) noexcept {
+		if (this != &other) {
+			::base58check_set_free(&set_);
+			set_ = other.set_, other.set_ = ::base58check_set { };
+		}
+		return *this;
+	}
+
+	~address_set() {
+		::base58check_set_free(&set_);
+	}
+
+	/** @brief Maps a set read-only from a file. See base58check_set_map(). */
+	static address_set map(const char *path) {
+		address_set ret;
+		check(::base58check_set_map(&ret.set_, path), path);
+		return ret;
+	}
+
+	/**
+	 * @brief Opens a set over an image in memory, which must outlive it. See
+	 * base58check_set_open().
+	 */
+	static address_set open(const void *image, size_t n_image) {
+		address_set ret;
+		check(::base58check_set_open(&ret.set_, image, n_image));
+		return ret;
+	}
+
+	/** @brief Saves the set to a file. See base58check_set_save(). */
+	void save(const char *path) const {
+		check(::base58check_set_save(&set_, path), path);
+	}
+
+#if __cplusplus >= 201703L
+	/**
+	 * @brief Returns whether a Base58Check encoding is valid and its payload
+	 * is in the set.
+	 */
+	bool contains(std::string_view in) const noexcept {
+		return ::base58check_set_contains(&set_, in.data(), in.size()) > 0;
+	}
+#else
+	/**
+	 * @brief Returns whether a Base58Check encoding is valid and its payload
+	 * is in the set.
+	 */
+	bool contains(const std::string &in) const noexcept {
+		return ::base58check_set_contains(&set_, in.data(), in.size()) > 0;
+	}
+#endif
+
+	/** @brief Returns whether a decoded payload is in the set. */
+	bool contains_payload(const byte payload[], size_t n_payload) const noexcept {
+		return ::base58check_set_contains_payload(&set_, reinterpret_cast<const unsigned char *>(payload), n_payload) > 0;
+	}
+
+	/** @brief Returns the number of payloads in the set. */
+	size_t size() const noexcept { return set_.n_items; }
+
+	/** @brief Returns the size of each payload in the set. */
+	size_t payload_size() const noexcept { return set_.n_payload; }
+};
+
+/**
+ * @brief Packs a batch of Base58Check encodings. See base58check_pack_batch().
+ * @throws std::invalid_argument if any encoding is not valid.
+ */
+static inline std::vector<byte>
+pack(const ::base58check_item in[], size_t n_items, unsigned flags = 0) {
+	std::vector<byte> ret;
+	size_t n_need = ::base58check_pack_batch_buffer_size(in, n_items, flags);
+	if (n_need == SIZE_MAX)
+		throw std::length_error("Base58Check batch is too large");
+	ret.resize(n_need);
+	unsigned char *out = reinterpret_cast<unsigned char *>(ret.data());
+	size_t n_out = ret.size();
+	int error = ::base58check_pack_batch(&out, &n_out, in, n_items, flags, nullptr);
+	if (error == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (error < 0)
+		throw std::invalid_argument("not a valid Base58Check encoding");
+	ret.resize(n_out);
+	return ret;
+}
+
+/**
+ * @brief Unpacks a pack into its Base58Check encodings, each followed by a
+ * newline. See base58check_unpack().
+ * @throws std::invalid_argument if the image is not that of a pack or the
+ * pack is corrupt.
+ */
+static inline std::string
+unpack(const void *image, size_t n_image, unsigned n_threads = 0) {
+	::base58check_pack pack;
+	size_t n_need;
+	if (::base58check_pack_open(&pack, image, n_image) < 0 ||
+			(n_need = ::base58check_unpack_buffer_size(&pack)) == SIZE_MAX)
+		throw std::invalid_argument("not a valid pack");
+	std::string ret;
+	ret.resize(n_need + 1); // never empty
+	char *out = &ret.front();
+	size_t n_out = ret.size();
+	if (::base58check_unpack(&out, &n_out, &pack, n_threads) < 0)
+		throw std::bad_alloc();
+	ret.resize(n_out);
+	return ret;
+}
+
+#if __cpp_lib_memory_resource >= 201603L
+namespace detail {
+
+// adapts a memory resource to the library's allocator interface
+static inline ::base58check_allocator resource_allocator(std::pmr::memory_resource *mr) noexcept {
+	::base58check_allocator allocator;
+	allocator.alloc = [](void *opaque, size_t size) noexcept -> void * {
+		try {
+			return static_cast<std::pmr::memory_resource *>(opaque)->allocate(size);
+		}
+		catch (...) {
+			return nullptr;
+		}
+	};
+	allocator.free = [](void *opaque, void *ptr, size_t size) noexcept {
+		static_cast<std::pmr::memory_resource *>(opaque)->deallocate(ptr, size);
+	};
+	allocator.opaque = mr;
+	return allocator;
+}
+
+} // namespace detail
+#endif
+
+/**
+ * @brief Owns a codec context whose scratch space is reused across calls.
+ */
+class context {
+	::base58check_ctx *ctx;
+
+public:
+	context() : ctx(::base58check_ctx_new()) {
+		if (!ctx)
+			throw std::bad_alloc();
+	}
+
+	/**
+	 * @brief Creates a context whose memory comes from the specified
+	 * allocator.
+	 * @see base58check_ctx_new_with_allocator()
+	 */
+	explicit context(const ::base58check_allocator &allocator) : ctx(::base58check_ctx_new_with_allocator(&allocator)) {
+		if (!ctx)
+			throw std::bad_alloc();
+	}
+
+#if __cpp_lib_memory_resource >= 201603L
+	/**
+	 * @brief Creates a context whose memory comes from the specified memory
+	 * resource, which must outlive the context.
+	 * @see base58check_ctx_new_with_allocator() for the one allocation that
+	 * does not.
+	 */
+	explicit context(std::pmr::memory_resource *mr) : context(detail::resource_allocator(mr)) { }
+#endif
+
+	context(context &&other) noexcept : ctx(other.ctx) { other.ctx = nullptr; }
+	context & operator=(context &&other) noexcept { std::swap(ctx, other.ctx); return *this; }
+
+	~context() {
+		if (ctx)
+			::base58check_ctx_free(ctx);
+	}
+
+	::base58check_ctx * get() const noexcept { return ctx; }
+
+	std::string encode(const byte in[], size_t n_in, size_t n_hdr = 0) {
+		std::string ret;
+		ret.resize(::base58check_encode_buffer_size(reinterpret_cast<const unsigned char *>(in), n_in, n_hdr));
+		char *out = &ret.front();
+		size_t n_out = ret.size();
+		if (::base58check_encode_ctx(ctx, &out, &n_out, reinterpret_cast<const unsigned char *>(in), n_in, n_hdr) < 0)
+			throw std::length_error("Base58Check encoding is too large");
+		ret.resize(n_out);
+		return ret;
+	}
+
+	std::vector<byte> decode(const char in[], size_t n_in, size_t n_hdr = 0) {
+		std::vector<byte> ret;
+		ret.resize(::base58check_decode_buffer_size(in, n_in, n_hdr));
+		unsigned char *out = reinterpret_cast<unsigned char *>(ret.data());
+		size_t n_out = ret.size();
+		if (::base58check_decode_ctx(ctx, &out, &n_out, in, n_in, n_hdr) < 0)
+			throw std::invalid_argument("not a valid Base58Check encoding");
+		ret.resize(n_out);
+		return ret;
+	}
+
+#if __cplusplus >= 201703L
+	std::vector<byte> decode(std::string_view in, size_t n_hdr = 0) {
+		return this->decode(in.data(), in.size(), n_hdr);
+	}
+#endif
+};
+
+/**
+ * @brief Owns an encoder for payloads that all begin with the same prefix.
+ */
+class prefix_encoder {
+	::base58check_prefix_encoder *enc;
+
+public:
+	prefix_encoder(const byte prefix[], size_t n_prefix, size_t n_tail) :
+			enc(::base58check_prefix_encoder_new(reinterpret_cast<const unsigned char *>(prefix), n_prefix, n_tail)) {
+		if (!enc)
+			throw std::bad_alloc();
+	}
+
+	prefix_encoder(prefix_encoder &&other) noexcept : enc(other.enc) { other.enc = nullptr; }
+	prefix_encoder & operator=(prefix_encoder &&other) noexcept { std::swap(enc, other.enc); return *this; }
+
+	~prefix_encoder() {
+		if (enc)
+			::base58check_prefix_encoder_free(enc);
+	}
+
+	const ::base58check_prefix_encoder * get() const noexcept { return enc; }
+
+	std::string encode(const byte tail[], size_t n_tail, size_t n_hdr = 0) const {
+		std::string ret;
+		ret.resize(::base58check_prefix_encode_buffer_size(enc, reinterpret_cast<const unsigned char *>(tail), n_tail, n_hdr));
+		char *out = &ret.front();
+		size_t n_out = ret.size();
+		if (::base58check_prefix_encode(enc, &out, &n_out, reinterpret_cast<const unsigned char *>(tail), n_tail, n_hdr) < 0)
+			throw std::length_error("Base58Check encoding is too large");
+		ret.resize(n_out);
+		return ret;
+	}
+};
+
+namespace detail {
+
+// largest output that the appending and iterator overloads stage on the stack
+static const size_t stack_buffer_size = BASE58CHECK_STACK_PAYLOAD_SIZE;
+
+// largest payload, including its checksum, whose scratch space a call made
+// without a context stages on the stack
+static const size_t stack_payload_size = BASE58CHECK_STACK_PAYLOAD_SIZE;
+
+template <typename Traits, typename Alloc>
+static inline void
+encode_append(::base58check_ctx *ctx, std::basic_string<char, Traits, Alloc> &out, const byte in[], size_t n_in, size_t n_hdr) {
+	const unsigned char *bin = reinterpret_cast<const unsigned char *>(in);
+	size_t pos = out.size(), n_need = ::base58check_encode_buffer_size(bin, n_in, n_hdr);
+	if (n_need > out.max_size() - pos)
+		throw std::length_error("Base58Check encoding is too large");
+	int ret = 0;
+	auto op = [&](char *p, size_t) noexcept -> size_t {
+		char *q = p + pos;
+		size_t n_out = n_need;
+		if ((ret = ::base58check_encode_ex(ctx, &q, &n_out, bin, n_in, n_hdr, 0)) < 0)
+			return pos;
+		std::memset(q, 0, n_hdr);
+		return pos + n_out;
+	};
+#if __cpp_lib_string_resize_and_overwrite >= 202110L
+	out.resize_and_overwrite(pos + n_need, op);
+#else
+	out.resize(pos + n_need);
+	out.resize(op(&out[0], out.size()));
+#endif
+	if (ret == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (ret < 0)
+		throw std::length_error("Base58Check encoding is too large");
+}
+
+template <typename Alloc>
+static inline void
+decode_append(::base58check_ctx *ctx, std::vector<byte, Alloc> &out, const char in[], size_t n_in, size_t n_hdr) {
+	size_t n_need = ::base58check_decode_buffer_size(in, n_in, n_hdr);
+	if (n_need <= stack_buffer_size) {
+		unsigned char buf[stack_buffer_size], *p = buf;
+		size_t n_out = sizeof buf;
+		int ret = ::base58check_decode_ex(ctx, &p, &n_out, in, n_in, n_hdr, 0);
+		if (ret == BASE58CHECK_ENOMEM)
+			throw std::bad_alloc();
+		if (ret < 0)
+			throw std::invalid_argument("not a valid Base58Check encoding");
+		std::memset(buf, 0, n_hdr);
+		out.insert(out.end(), reinterpret_cast<const byte *>(buf), reinterpret_cast<const byte *>(buf) + n_out);
+		return;
+	}
+	size_t pos = out.size();
+	out.resize(pos + n_need);
+	unsigned char *p = reinterpret_cast<unsigned char *>(out.data() + pos);
+	size_t n_out = n_need;
+	int ret = ::base58check_decode_ex(ctx, &p, &n_out, in, n_in, n_hdr, 0);
+	out.resize(ret < 0 ? pos : pos + n_out);
+	if (ret == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (ret < 0)
+		throw std::invalid_argument("not a valid Base58Check encoding");
+}
+
+} // namespace detail
+
+/**
+ * @brief Appends the Base58Check encoding of data to a string.
+ * @details The string grows by at most base58check_encode_buffer_size() bytes,
+ * reusing its capacity, and its slack is not zero-filled first where the
+ * library provides @c std::string::resize_and_overwrite.
+ * @param out The string to append to.
+ * @param in A pointer to the data to be encoded.
+ * @param n_in The number of bytes of data at @p in.
+ * @param n_hdr The number of zero bytes to append ahead of the encoding.
+ * @return @p out.
+ */
+template <typename Traits, typename Alloc>
+static inline std::basic_string<char, Traits, Alloc> &
+encode_append(std::basic_string<char, Traits, Alloc> &out, const byte in[], size_t n_in, size_t n_hdr = 0) {
+	detail::encode_append(nullptr, out, in, n_in, n_hdr);
+	return out;
+}
+
+/**
+ * @brief Appends the decoding of a Base58Check encoding to a vector.
+ * @details Decodings that fit in a small buffer on the stack are inserted
+ * from there, so the vector's slack is never value-initialized for them.
+ * @param out The vector to append to.
+ * @param in A pointer to the Base58Check encoding to be decoded.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @param n_hdr The number of zero bytes to append ahead of the decoded data.
+ * @return @p out.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding,
+ * in which case @p out is unchanged.
+ */
+template <typename Alloc>
+static inline std::vector<byte, Alloc> &
+decode_append(std::vector<byte, Alloc> &out, const char in[], size_t n_in, size_t n_hdr = 0) {
+	detail::decode_append(nullptr, out, in, n_in, n_hdr);
+	return out;
+}
+
+/**
+ * @brief Encodes data in Base58Check format into a string that uses the
+ * specified allocator.
+ * @details Scratch space that the library needs for large inputs still comes
+ * from base58check_malloc(); see pmr::encode() for a variant that takes that
+ * from a memory resource too.
+ * @param in A pointer to the data to be encoded.
+ * @param n_in The number of bytes of data at @p in.
+ * @param n_hdr The number of zero bytes to place ahead of the encoding.
+ * @param alloc The allocator of the returned string.
+ * @return The encoding, preceded by @p n_hdr zero bytes.
+ */
+template <typename Alloc>
+static inline std::basic_string<char, std::char_traits<char>, Alloc>
+encode(const byte in[], size_t n_in, size_t n_hdr, const Alloc &alloc) {
+	std::basic_string<char, std::char_traits<char>, Alloc> ret(alloc);
+	detail::encode_append(nullptr, ret, in, n_in, n_hdr);
+	return ret;
+}
+
+/**
+ * @brief Decodes a Base58Check encoding into a vector that uses the specified
+ * allocator.
+ * @details Scratch space that the library needs for large inputs still comes
+ * from base58check_malloc(); see pmr::decode() for a variant that takes that
+ * from a memory resource too.
+ * @param in A pointer to the Base58Check encoding to be decoded.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @param n_hdr The number of zero bytes to place ahead of the decoded data.
+ * @param alloc The allocator of the returned vector.
+ * @return The decoded data, preceded by @p n_hdr zero bytes.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding.
+ */
+template <typename Alloc>
+static inline std::vector<byte, Alloc>
+decode(const char in[], size_t n_in, size_t n_hdr, const Alloc &alloc) {
+	std::vector<byte, Alloc> ret(alloc);
+	detail::decode_append(nullptr, ret, in, n_in, n_hdr);
+	return ret;
+}
+
+/**
+ * @brief Writes the Base58Check encoding of data to an output iterator.
+ * @param out An output iterator to which to write the characters of the
+ * encoding.
+ * @param in A pointer to the data to be encoded.
+ * @param n_in The number of bytes of data at @p in.
+ * @return The output iterator after the last character written.
+ */
+template <typename OutputIt>
+static inline OutputIt
+encode_to(OutputIt out, const byte in[], size_t n_in) {
+	const unsigned char *bin = reinterpret_cast<const unsigned char *>(in);
+	if (::base58check_encode_buffer_size(bin, n_in, 0) <= detail::stack_buffer_size) {
+		char buf[detail::stack_buffer_size], *p = buf;
+		size_t n_out = sizeof buf;
+		int ret = ::base58check_encode(&p, &n_out, bin, n_in, 0);
+		if (ret == BASE58CHECK_ENOMEM)
+			throw std::bad_alloc();
+		if (ret < 0)
+			throw std::length_error("Base58Check encoding is too large");
+		for (size_t i = 0; i < n_out; ++i)
+			*out++ = buf[i];
+		return out;
+	}
+	std::string str = ::base58check::encode(in, n_in);
+	for (char c : str)
+		*out++ = c;
+	return out;
+}
+
+/**
+ * @brief Writes the decoding of a Base58Check encoding to an output iterator.
+ * @param out An output iterator to which to write the decoded bytes.
+ * @param in A pointer to the Base58Check encoding to be decoded.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @return The output iterator after the last byte written.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding,
+ * in which case nothing is written.
+ */
+template <typename OutputIt>
+static inline OutputIt
+decode_to(OutputIt out, const char in[], size_t n_in) {
+	if (::base58check_decode_buffer_size(in, n_in, 0) <= detail::stack_buffer_size) {
+		unsigned char buf[detail::stack_buffer_size], *p = buf;
+		size_t n_out = sizeof buf;
+		int ret = ::base58check_decode(&p, &n_out, in, n_in, 0);
+		if (ret == BASE58CHECK_ENOMEM)
+			throw std::bad_alloc();
+		if (ret < 0)
+			throw std::invalid_argument("not a valid Base58Check encoding");
+		for (size_t i = 0; i < n_out; ++i)
+			*out++ = static_cast<byte>(buf[i]);
+		return out;
+	}
+	std::vector<byte> bytes = ::base58check::decode(in, n_in);
+	for (byte b : bytes)
+		*out++ = b;
+	return out;
+}
+
+#if __cpp_concepts >= 201907L
+template <typename T> requires std::is_trivially_copyable_v<T>
+#else
+template <typename T, typename std::enable_if<std::is_trivially_copyable<T>::value, bool>::type = true>
+#endif
+static inline std::string
+__attribute__ ((__pure__))
+encode(const T in[], size_t n_in, size_t n_hdr = 0) {
 	return ::base58check::encode(reinterpret_cast<const byte *>(in), n_in * sizeof(T), n_hdr);
 }
 
@@ -231,6 +1811,509 @@ decode(std::string_view in, size_t n_hdr = 0) {
 	return ::base58check::decode(in.data(), in.size(), n_hdr);
 }
 
+static inline std::vector<byte>
+__attribute__ ((__pure__))
+decode_raw(std::string_view in, size_t n_hdr = 0) {
+	return ::base58check::decode_raw(in.data(), in.size(), n_hdr);
+}
+
+static inline std::vector<byte>
+__attribute__ ((__pure__))
+decode_trusted(std::string_view in, size_t n_hdr = 0) {
+	return ::base58check::decode_trusted(in.data(), in.size(), n_hdr);
+}
+
+template <typename Alloc>
+static inline std::vector<byte, Alloc> &
+decode_append(std::vector<byte, Alloc> &out, std::string_view in, size_t n_hdr = 0) {
+	return ::base58check::decode_append(out, in.data(), in.size(), n_hdr);
+}
+
+template <typename OutputIt>
+static inline OutputIt
+decode_to(OutputIt out, std::string_view in) {
+	return ::base58check::decode_to(out, in.data(), in.size());
+}
+
+static inline bool
+__attribute__ ((__pure__))
+is_valid(std::string_view in) noexcept {
+	return ::base58check::is_valid(in.data(), in.size());
+}
+
+#if __cpp_lib_memory_resource >= 201603L
+namespace pmr {
+
+/**
+ * @brief Encodes data in Base58Check format into a string whose memory, and
+ * any scratch space that the library needs, come from a memory resource.
+ * @details Small inputs are encoded with scratch space on the stack, so the
+ * only allocation from @p mr is the string's.
+ * @param in A pointer to the data to be encoded.
+ * @param n_in The number of bytes of data at @p in.
+ * @param n_hdr The number of zero bytes to place ahead of the encoding.
+ * @param mr The memory resource to allocate from.
+ * @return The encoding, preceded by @p n_hdr zero bytes.
+ */
+static inline std::pmr::string
+encode(const byte in[], size_t n_in, size_t n_hdr = 0, std::pmr::memory_resource *mr = std::pmr::get_default_resource()) {
+	std::pmr::string ret(mr);
+	if (n_in <= detail::stack_payload_size - 4)
+		detail::encode_append(nullptr, ret, in, n_in, n_hdr);
+	else
+		detail::encode_append(context(mr).get(), ret, in, n_in, n_hdr);
+	return ret;
+}
+
+/**
+ * @brief Decodes a Base58Check encoding into a vector whose memory, and any
+ * scratch space that the library needs, come from a memory resource.
+ * @details Small inputs are decoded with scratch space on the stack, so the
+ * only allocation from @p mr is the vector's.
+ * @param in A pointer to the Base58Check encoding to be decoded.
+ * @param n_in The size of the Base58Check encoding at @p in.
+ * @param n_hdr The number of zero bytes to place ahead of the decoded data.
+ * @param mr The memory resource to allocate from.
+ * @return The decoded data, preceded by @p n_hdr zero bytes.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding.
+ */
+static inline std::pmr::vector<byte>
+decode(const char in[], size_t n_in, size_t n_hdr = 0, std::pmr::memory_resource *mr = std::pmr::get_default_resource()) {
+	std::pmr::vector<byte> ret(mr);
+	if (n_in <= detail::stack_payload_size - 4)
+		detail::decode_append(nullptr, ret, in, n_in, n_hdr);
+	else
+		detail::decode_append(context(mr).get(), ret, in, n_in, n_hdr);
+	return ret;
+}
+
+static inline std::pmr::vector<byte>
+decode(std::string_view in, size_t n_hdr = 0, std::pmr::memory_resource *mr = std::pmr::get_default_resource()) {
+	return ::base58check::pmr::decode(in.data(), in.size(), n_hdr, mr);
+}
+
+} // namespace pmr
+#endif // __cpp_lib_memory_resource >= 201603L
+
+namespace detail {
+
+#ifdef __SIZEOF_INT128__
+using limb_t = std::uint64_t;
+__extension__ using dlimb_t = unsigned __int128;
+#else
+using limb_t = std::uint32_t;
+using dlimb_t = std::uint64_t;
+#endif
+
+static constexpr unsigned limb_bits = sizeof(limb_t) * 8;
+// 58**10 < 2**64 and 58**5 < 2**32
+static constexpr unsigned limb_digits = sizeof(limb_t) == 8 ? 10 : 5;
+
+static constexpr char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static constexpr std::int8_t digit_of(char c) noexcept {
+	return c >= '1' && c <= '9' ? static_cast<std::int8_t>(c - '1') :
+		c >= 'A' && c <= 'H' ? static_cast<std::int8_t>(c - 'A' + 9) :
+		c >= 'J' && c <= 'N' ? static_cast<std::int8_t>(c - 'J' + 17) :
+		c >= 'P' && c <= 'Z' ? static_cast<std::int8_t>(c - 'P' + 22) :
+		c >= 'a' && c <= 'k' ? static_cast<std::int8_t>(c - 'a' + 33) :
+		c >= 'm' && c <= 'z' ? static_cast<std::int8_t>(c - 'm' + 44) : -1;
+}
+
+// Divides the digits of the big-endian number value[0..n), which is consumed,
+// out to the end of chars[0..n_chars), least significant first, and returns
+// the position of the most significant. Usable in constant expressions.
+static constexpr size_t divide_digits(char chars[], size_t n_chars, std::uint8_t value[], size_t n) noexcept {
+	size_t first = 0, pos = n_chars;
+	for (;;) {
+		while (first < n && !value[first])
+			++first;
+		if (first == n)
+			return pos;
+		unsigned rem = 0;
+		for (size_t i = first; i < n; ++i) {
+			rem = rem << 8 | value[i];
+			value[i] = static_cast<std::uint8_t>(rem / 58);
+			rem %= 58;
+		}
+		chars[--pos] = alphabet[rem];
+	}
+}
+
+static constexpr std::array<limb_t, limb_digits + 1> make_powers() noexcept {
+	std::array<limb_t, limb_digits + 1> powers { };
+	powers[0] = 1;
+	for (unsigned k = 1; k <= limb_digits; ++k)
+		powers[k] = powers[k - 1] * 58;
+	return powers;
+}
+
+// powers[k] == 58**k
+static constexpr std::array<limb_t, limb_digits + 1> powers = make_powers();
+
+static constexpr unsigned leading_zero_bits(limb_t x) noexcept {
+	unsigned n = 0;
+	for (; !(x >> (limb_bits - 1)); x <<= 1)
+		++n;
+	return n;
+}
+
+// 58**limb_digits, normalized, with its reciprocal for Möller-Granlund division
+static constexpr unsigned base_shift = leading_zero_bits(powers[limb_digits]);
+static constexpr limb_t base_norm = powers[limb_digits] << base_shift;
+static constexpr limb_t base_inv = static_cast<limb_t>(~dlimb_t() / base_norm - (dlimb_t(1) << limb_bits));
+
+// Divides (r * 58**limb_digits + u) by 58**limb_digits, where r < 58**limb_digits.
+// Returns the quotient and replaces r with the remainder.
+static inline limb_t divrem(limb_t &r, limb_t u) noexcept {
+	limb_t n1 = r << base_shift | u >> (limb_bits - base_shift), n0 = u << base_shift;
+	dlimb_t p = dlimb_t(base_inv) * n1 + (dlimb_t(n1) << limb_bits | n0);
+	limb_t q = static_cast<limb_t>(p >> limb_bits) + 1, rem = n0 - q * base_norm;
+	if (rem > static_cast<limb_t>(p))
+		--q, rem += base_norm;
+	if (__builtin_expect(rem >= base_norm, 0))
+		++q, rem -= base_norm;
+	r = rem >> base_shift;
+	return q;
+}
+
+// Divides limbs[0..sizeof...(I)) in place by 58**limb_digits, most significant
+// limb first, leaving the remainder in r. Expands to straight-line code.
+template <size_t... I>
+static inline void divide_limbs(limb_t limbs[], limb_t &r, std::index_sequence<I...>) noexcept {
+	constexpr size_t n = sizeof...(I);
+	((limbs[n - 1 - I] = divrem(r, limbs[n - 1 - I])), ...);
+}
+
+// Multiplies limbs[0..sizeof...(I)) in place by 58**limb_digits and adds carry,
+// least significant limb first. Expands to straight-line code.
+template <size_t... I>
+static inline void multiply_limbs(limb_t limbs[], limb_t carry, std::index_sequence<I...>) noexcept {
+	dlimb_t t = 0;
+	((t = dlimb_t(limbs[I]) * powers[limb_digits] + carry,
+		limbs[I] = static_cast<limb_t>(t), carry = static_cast<limb_t>(t >> limb_bits)), ...);
+}
+
+} // namespace detail
+
+/**
+ * @brief Encodes fixed-size data in Base58Check format without allocating.
+ * @details The digit count and the number of significant limbs at every step
+ * of the base conversion are computed at compile time, so the conversion is
+ * fully unrolled on native integers.
+ * @tparam N The size in bytes of the data to be encoded.
+ */
+template <size_t N>
+class fixed_encoder {
+	static constexpr size_t n_bytes = N + 4;
+	static constexpr size_t n_limbs = (n_bytes + sizeof(detail::limb_t) - 1) / sizeof(detail::limb_t);
+
+public:
+	/** @brief The maximum size of an encoding. */
+	// 1430893/1047768 approximates log(256)/log(58) from above
+	static constexpr size_t max_size = (n_bytes * 1430893 + (1047768 - 1)) / 1047768;
+
+	/** @brief Holds an encoding. */
+	struct result {
+		std::array<char, max_size> chars;
+		size_t size;
+
+		constexpr const char * data() const noexcept { return chars.data(); }
+		constexpr const char * begin() const noexcept { return chars.data(); }
+		constexpr const char * end() const noexcept { return chars.data() + size; }
+		constexpr operator std::string_view () const noexcept { return { chars.data(), size }; }
+		explicit operator std::string () const { return { chars.data(), size }; }
+	};
+
+private:
+	static constexpr size_t n_groups = (max_size + detail::limb_digits - 1) / detail::limb_digits;
+
+	// An upper bound on the number of nonzero limbs left after g groups of
+	// digits have been divided out. 5857/1000 approximates log2(58) from below.
+	static constexpr size_t live_limbs(size_t g) noexcept {
+		size_t bits = n_bytes * 8, shed = g * detail::limb_digits * 5857 / 1000;
+		return bits > shed ? (bits - shed + detail::limb_bits - 1) / detail::limb_bits : 0;
+	}
+
+	template <size_t G>
+	static inline void divide_group(detail::limb_t limbs[], std::uint8_t digits[]) noexcept {
+		detail::limb_t r = 0;
+		detail::divide_limbs(limbs, r, std::make_index_sequence<live_limbs(G)>());
+		for (size_t k = 1; k <= detail::limb_digits; ++k)
+			digits[(n_groups - G) * detail::limb_digits - k] = static_cast<std::uint8_t>(r % 58), r /= 58;
+	}
+
+	template <size_t... G>
+	static inline void divide_groups(detail::limb_t limbs[], std::uint8_t digits[], std::index_sequence<G...>) noexcept {
+		(divide_group<G>(limbs, digits), ...);
+	}
+
+public:
+	/**
+	 * @brief Encodes data in Base58Check format.
+	 * @param[in] in A pointer to the @p N bytes of data to be encoded.
+	 * @return The encoding.
+	 */
+	static result encode(const byte in[]) noexcept {
+		unsigned char bytes[n_bytes], checksum[4];
+		std::memcpy(bytes, in, N);
+		::base58check_checksum(checksum, bytes, N);
+		std::memcpy(bytes + N, checksum, 4);
+
+		detail::limb_t limbs[n_limbs] = { };
+		for (size_t i = 0; i < n_bytes; ++i)
+			limbs[(n_bytes - 1 - i) / sizeof(detail::limb_t)] |=
+				detail::limb_t(bytes[i]) << (n_bytes - 1 - i) % sizeof(detail::limb_t) * 8;
+
+		std::uint8_t digits[n_groups * detail::limb_digits];
+		divide_groups(limbs, digits, std::make_index_sequence<n_groups>());
+
+		result ret;
+		size_t n_leading_zeros = 0, first = 0;
+		while (n_leading_zeros < N && bytes[n_leading_zeros] == 0)
+			ret.chars[n_leading_zeros++] = '1';
+		while (first < sizeof digits && digits[first] == 0)
+			++first;
+		ret.size = n_leading_zeros + (sizeof digits - first);
+		for (size_t i = n_leading_zeros; i < ret.size; ++i)
+			ret.chars[i] = detail::alphabet[digits[first++]];
+		return ret;
+	}
+
+	/** @overload */
+	static result encode(const byte (&in)[N]) noexcept {
+		return encode(static_cast<const byte *>(in));
+	}
+
+	/** @overload */
+	static result encode(const std::array<byte, N> &in) noexcept {
+		return encode(in.data());
+	}
+};
+
+/**
+ * @brief Decodes fixed-size data from Base58Check format without allocating.
+ * @details The digit count and the number of significant limbs at every step
+ * of the base conversion are computed at compile time, so the conversion is
+ * fully unrolled on native integers.
+ * @tparam N The size in bytes of the decoded data, not including the checksum.
+ */
+template <size_t N>
+class fixed_decoder {
+	static constexpr size_t n_bytes = N + 4;
+	// one extra limb catches values too large for n_bytes
+	static constexpr size_t n_limbs = (n_bytes + sizeof(detail::limb_t) - 1) / sizeof(detail::limb_t) + 1;
+
+public:
+	/** @brief The maximum size of an encoding that can decode to @p N bytes. */
+	static constexpr size_t max_size = fixed_encoder<N>::max_size;
+
+private:
+	static constexpr size_t n_groups = (max_size + detail::limb_digits - 1) / detail::limb_digits;
+
+	// An upper bound on the number of nonzero limbs after g groups of digits
+	// have been multiplied in. 5858/1000 approximates log2(58) from above.
+	static constexpr size_t live_limbs(size_t g) noexcept {
+		size_t bits = g * detail::limb_digits * 5858 / 1000 + 1;
+		bits = (bits + detail::limb_bits - 1) / detail::limb_bits;
+		return bits < n_limbs ? bits : n_limbs;
+	}
+
+	template <size_t G>
+	static inline void multiply_group(detail::limb_t limbs[], const std::uint8_t digits[]) noexcept {
+		detail::limb_t carry = 0;
+		for (size_t k = 0; k < detail::limb_digits; ++k)
+			carry = carry * 58 + digits[G * detail::limb_digits + k];
+		detail::multiply_limbs(limbs, carry, std::make_index_sequence<live_limbs(G + 1)>());
+	}
+
+	template <size_t... G>
+	static inline void multiply_groups(detail::limb_t limbs[], const std::uint8_t digits[], std::index_sequence<G...>) noexcept {
+		(multiply_group<G>(limbs, digits), ...);
+	}
+
+public:
+	/**
+	 * @brief Decodes data from Base58Check format.
+	 * @param[out] out A reference to an array that will receive the decoded
+	 * data.
+	 * @param[in] in A pointer to the Base58Check encoding to be decoded.
+	 * @param n_in The size of the Base58Check encoding at @p in.
+	 * @return 0 if the decoding was successful, or a negative error code if
+	 * the encoding contained an illegal character (#BASE58CHECK_ECHAR), did not
+	 * decode to exactly @p N bytes (#BASE58CHECK_ELENGTH), or had a checksum
+	 * mismatch (#BASE58CHECK_ECHECKSUM).
+	 */
+	static int decode(std::array<byte, N> &out, const char in[], size_t n_in) noexcept {
+		if (n_in > max_size)
+			return BASE58CHECK_ELENGTH;
+		std::uint8_t digits[n_groups * detail::limb_digits] = { };
+		for (size_t i = 0, j = sizeof digits - n_in; i < n_in; ++i, ++j) {
+			std::int8_t digit = detail::digit_of(in[i]);
+			if (digit < 0)
+				return BASE58CHECK_ECHAR;
+			digits[j] = static_cast<std::uint8_t>(digit);
+		}
+		size_t n_leading_zeros = 0;
+		while (n_leading_zeros < n_in && in[n_leading_zeros] == '1')
+			++n_leading_zeros;
+		if (n_leading_zeros > n_bytes)
+			return BASE58CHECK_ELENGTH;
+
+		detail::limb_t limbs[n_limbs] = { };
+		multiply_groups(limbs, digits, std::make_index_sequence<n_groups>());
+
+		// the value must occupy exactly the bytes not covered by leading zeros
+		unsigned char bytes[n_limbs * sizeof(detail::limb_t)];
+		for (size_t i = 0; i < sizeof bytes; ++i)
+			bytes[sizeof bytes - 1 - i] = static_cast<unsigned char>(limbs[i / sizeof(detail::limb_t)] >> i % sizeof(detail::limb_t) * 8);
+		size_t n_value = n_bytes - n_leading_zeros, first = sizeof bytes - n_value;
+		for (size_t i = 0; i < first; ++i)
+			if (bytes[i])
+				return BASE58CHECK_ELENGTH;
+		if (n_value && !bytes[first])
+			return BASE58CHECK_ELENGTH;
+
+		const unsigned char *payload = bytes + sizeof bytes - n_bytes;
+		unsigned char checksum[4];
+		::base58check_checksum(checksum, payload, N);
+		if (std::memcmp(checksum, payload + N, 4))
+			return BASE58CHECK_ECHECKSUM;
+		std::memcpy(out.data(), payload, N);
+		return 0;
+	}
+
+	/**
+	 * @brief Decodes data from Base58Check format.
+	 * @param in The Base58Check encoding to be decoded.
+	 * @return The decoded data.
+	 * @throw std::invalid_argument if @p in is not a valid Base58Check encoding
+	 * of @p N bytes of data.
+	 */
+	static std::array<byte, N> decode(std::string_view in) {
+		std::array<byte, N> ret;
+		if (decode(ret, in.data(), in.size()) < 0)
+			throw std::invalid_argument("not a valid Base58Check encoding");
+		return ret;
+	}
+};
+
+/**
+ * @brief A format of Base58Check encoded data for use with decode_as().
+ * @details Any other type that has a @c size and a @c version like these can
+ * be used as a format as well.
+ * @tparam N The size in bytes of the decoded data, including the version.
+ * @tparam Version The bytes with which the decoded data begin.
+ */
+template <size_t N, unsigned char... Version>
+struct format {
+	static_assert(sizeof...(Version) <= N, "version is longer than the data");
+	/** @brief The size in bytes of the decoded data, including the version. */
+	static constexpr size_t size = N;
+	/** @brief The bytes with which the decoded data begin. */
+	static constexpr std::array<unsigned char, sizeof...(Version)> version { { Version... } };
+};
+
+namespace detail {
+
+// The least and greatest encodings, less their leading '1' characters, of
+// data of a format. Equally long encodings compare as their numbers do, as
+// the alphabet is in ASCII order, so a string between them of either length
+// is a plausible encoding.
+template <size_t N>
+struct format_bounds {
+	std::array<char, N> lo { }, hi { };
+	size_t n_lo = 0, n_hi = 0, n_ones = 0;
+	bool bounded = false;
+};
+
+template <typename Format>
+static constexpr auto make_format_bounds() noexcept {
+	constexpr size_t n = Format::size + 4;
+	format_bounds<fixed_encoder<Format::size>::max_size> ret { };
+	const auto &version = Format::version;
+	while (ret.n_ones < version.size() && !version[ret.n_ones])
+		++ret.n_ones;
+	// a version of all zeros doesn't bound the number that follows
+	if (!(ret.bounded = ret.n_ones < version.size()))
+		return ret;
+	std::uint8_t lo[n] = { }, hi[n] = { };
+	for (size_t i = 0; i < n; ++i)
+		lo[i] = i < version.size() ? static_cast<std::uint8_t>(version[i]) : 0,
+		hi[i] = i < version.size() ? static_cast<std::uint8_t>(version[i]) : 0xFF;
+	size_t pos = divide_digits(ret.lo.data(), ret.lo.size(), lo, n);
+	for (size_t i = pos; i < ret.lo.size(); ++i)
+		ret.lo[ret.n_lo++] = ret.lo[i];
+	pos = divide_digits(ret.hi.data(), ret.hi.size(), hi, n);
+	for (size_t i = pos; i < ret.hi.size(); ++i)
+		ret.hi[ret.n_hi++] = ret.hi[i];
+	return ret;
+}
+
+template <typename Format>
+static constexpr auto format_bounds_of = make_format_bounds<Format>();
+
+} // namespace detail
+
+/**
+ * @brief Decodes a Base58Check encoding of data of a known format.
+ * @details The range of encodings that data of the format can have is
+ * computed at compile time, so an encoding outside of it is rejected by its
+ * length and leading characters alone. Others are decoded by
+ * base58check_decode_expect().
+ * @tparam Format The expected format, such as a specialization of format.
+ * @param[out] out A reference to an array that will receive the decoded data,
+ * including the version.
+ * @param in The Base58Check encoding to be decoded.
+ * @return 0 if the decoding was successful, or a negative error code as
+ * base58check_decode_expect() returns.
+ */
+template <typename Format>
+static inline int
+decode_as(std::array<byte, Format::size> &out, std::string_view in) noexcept {
+	constexpr auto &bounds = detail::format_bounds_of<Format>;
+	if constexpr (bounds.bounded) {
+		std::string_view lo(bounds.lo.data(), bounds.n_lo), hi(bounds.hi.data(), bounds.n_hi);
+		if (in.size() < bounds.n_ones + lo.size() || in.size() > bounds.n_ones + hi.size())
+			return BASE58CHECK_ELENGTH;
+		std::string_view digits = in.substr(bounds.n_ones);
+		if ((digits.size() == lo.size() && digits < lo) || (digits.size() == hi.size() && digits > hi))
+			return BASE58CHECK_EVERSION;
+	}
+	return ::base58check_decode_expect(reinterpret_cast<unsigned char *>(out.data()), out.size(), in.data(), in.size(),
+		Format::version.size() ? reinterpret_cast<const unsigned char *>(Format::version.data()) : nullptr, Format::version.size());
+}
+
+/**
+ * @brief Decodes a Base58Check encoding of data of a known format.
+ * @tparam Format The expected format, such as a specialization of format.
+ * @param in The Base58Check encoding to be decoded.
+ * @return The decoded data, including the version.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding
+ * of data of the format. The message tells which check failed.
+ */
+template <typename Format>
+static inline std::array<byte, Format::size>
+decode_as(std::string_view in) {
+	std::array<byte, Format::size> ret;
+	switch (decode_as<Format>(ret, in)) {
+		case 0:
+			return ret;
+		case BASE58CHECK_ECHAR:
+			throw std::invalid_argument("Base58Check encoding contains an illegal character");
+		case BASE58CHECK_ELENGTH:
+			throw std::invalid_argument("Base58Check encoding is of the wrong length");
+		case BASE58CHECK_EVERSION:
+			throw std::invalid_argument("Base58Check encoding has the wrong version");
+		case BASE58CHECK_ECHECKSUM:
+			throw std::invalid_argument("Base58Check encoding has a checksum mismatch");
+		case BASE58CHECK_ENOMEM:
+			throw std::bad_alloc();
+		default:
+			throw std::invalid_argument("not a valid Base58Check encoding");
+	}
+}
+
 #if __cplusplus >= 202002L
 
 #if __cpp_concepts >= 201907L
@@ -244,6 +2327,396 @@ encode(std::span<const T> in, size_t n_hdr = 0) {
 	return ::base58check::encode(in.as_bytes().data(), in.size_bytes(), n_hdr);
 }
 
+/**
+ * @brief Encodes data in Base58Check format into caller-supplied storage.
+ * @param out The storage into which to write the encoding, which should be at
+ * least as large as base58check_encode_buffer_size() says.
+ * @param in A pointer to the data to be encoded.
+ * @param n_in The number of bytes of data at @p in.
+ * @param n_hdr The number of bytes to skip at the front of @p out before
+ * writing the encoding. They are left untouched.
+ * @return The number of bytes of @p out used, including the @p n_hdr bytes.
+ * @throw std::length_error if @p out is too small.
+ */
+static inline size_t
+encode_into(std::span<char> out, const byte in[], size_t n_in, size_t n_hdr = 0) {
+	char dummy, *p = out.empty() ? &dummy : out.data(); // never null, so nothing is allocated
+	size_t n_out = out.size();
+	int ret = ::base58check_encode(&p, &n_out, reinterpret_cast<const unsigned char *>(in), n_in, n_hdr);
+	if (ret == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (ret < 0)
+		throw std::length_error("buffer is too small for Base58Check encoding");
+	return n_out;
+}
+
+/**
+ * @brief Decodes data from Base58Check format into caller-supplied storage.
+ * @param out The storage into which to write the decoded data, which should
+ * be at least as large as base58check_decode_buffer_size() says.
+ * @param in The Base58Check encoding to be decoded.
+ * @param n_hdr The number of bytes to skip at the front of @p out before
+ * writing the decoded data. They are left untouched.
+ * @return The number of bytes of @p out used, including the @p n_hdr bytes.
+ * @throw std::length_error if @p out is too small.
+ * @throw std::invalid_argument if @p in is not a valid Base58Check encoding.
+ */
+static inline size_t
+decode_into(std::span<byte> out, std::string_view in, size_t n_hdr = 0) {
+	unsigned char dummy, *p = out.empty() ? &dummy : reinterpret_cast<unsigned char *>(out.data());
+	size_t n_out = out.size();
+	int ret = ::base58check_decode(&p, &n_out, in.data(), in.size(), n_hdr);
+	if (ret == BASE58CHECK_ESIZE)
+		throw std::length_error("buffer is too small for Base58Check decoding");
+	if (ret == BASE58CHECK_ENOMEM)
+		throw std::bad_alloc();
+	if (ret < 0)
+		throw std::invalid_argument("not a valid Base58Check encoding");
+	return n_out;
+}
+
+/**
+ * @brief An element of a view produced by views::encode.
+ */
+struct encoded_item {
+	/** @brief The encoding, which remains valid until the view's iterator is
+	 * next advanced. */
+	std::string_view text;
+	/** @brief 0, or a negative error code if the element could not be encoded. */
+	int error;
+
+	explicit operator bool () const noexcept { return !error; }
+};
+
+/**
+ * @brief An element of a view produced by views::decode.
+ */
+struct decoded_item {
+	/** @brief The decoded data, which remain valid until the view's iterator
+	 * is next advanced. */
+	std::span<const byte> data;
+	/** @brief 0, or a negative error code if the element could not be decoded
+	 * (see base58check_decode()). */
+	int error;
+
+	explicit operator bool () const noexcept { return !error; }
+};
+
+namespace detail {
+
+// Elements are referred to, not copied, while their group is converted, so
+// they must be lvalues or themselves views.
+template <typename R, typename T>
+concept element_of = std::convertible_to<R, T> &&
+	(std::is_lvalue_reference_v<R> || std::is_same_v<std::remove_cvref_t<R>, T>);
+
+// number of elements converted per call into the library's batch functions
+static constexpr size_t view_batch_size = 64;
+
+// An input view that converts the elements of V a group at a time into one
+// reused scratch buffer.
+template <std::ranges::view V, bool Decode>
+class batch_view : public std::ranges::view_interface<batch_view<V, Decode>> {
+	using element = std::conditional_t<Decode, std::string_view, std::span<const byte>>;
+	using item = std::conditional_t<Decode, decoded_item, encoded_item>;
+	using out_char = std::conditional_t<Decode, unsigned char, char>;
+
+	V base;
+	std::ranges::iterator_t<V> next;
+	std::vector<::base58check_item> items;
+	std::vector<size_t> offsets;
+	std::vector<int> results;
+	std::vector<out_char> buf;
+	size_t pos = 0;
+
+	void fill() {
+		items.clear(), pos = 0;
+		for (; items.size() < view_batch_size && next != std::ranges::end(base); ++next) {
+			element e = *next;
+			items.push_back({ e.empty() ? static_cast<const void *>("") : e.data(), e.size() }); // never null
+		}
+		size_t n = items.size();
+		if (!n)
+			return;
+		offsets.assign(n + 1, 0);
+		results.assign(n, 0);
+		size_t n_need = Decode ? ::base58check_decode_batch_buffer_size(items.data(), n, 1) :
+				::base58check_encode_batch_buffer_size(items.data(), n, 1);
+		int ret = BASE58CHECK_ESIZE;
+		if (n_need != SIZE_MAX) {
+			if (buf.size() < n_need)
+				buf.resize(n_need);
+			out_char *out = buf.data();
+			size_t n_out = buf.size();
+			if constexpr (Decode)
+				ret = ::base58check_decode_batch(&out, &n_out, offsets.data(), results.data(), items.data(), n);
+			else
+				ret = ::base58check_encode_batch(&out, &n_out, offsets.data(), items.data(), n);
+		}
+		if (ret < 0) {
+			// a failure of the whole group is reported for each of its elements
+			offsets.assign(n + 1, 0);
+			results.assign(n, ret);
+		}
+	}
+
+public:
+	class iterator {
+		batch_view *view;
+
+	public:
+		using value_type = item;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(batch_view *view) noexcept : view(view) { }
+
+		item operator*() const noexcept {
+			size_t i = view->pos, begin = view->offsets[i], end = view->offsets[i + 1];
+			if constexpr (Decode)
+				return { { reinterpret_cast<const byte *>(view->buf.data()) + begin, end - begin }, view->results[i] };
+			else
+				return { { view->buf.data() + begin, end - begin }, view->results[i] };
+		}
+
+		iterator & operator++() {
+			if (++view->pos == view->items.size())
+				view->fill();
+			return *this;
+		}
+
+		void operator++(int) { ++*this; }
+
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return view->pos == view->items.size();
+		}
+	};
+
+	batch_view() = default;
+	explicit batch_view(V base) : base(std::move(base)) { }
+
+	iterator begin() {
+		next = std::ranges::begin(base);
+		fill();
+		return iterator(this);
+	}
+
+	std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+};
+
+template <bool Decode>
+struct batch_adaptor {
+	using element = std::conditional_t<Decode, std::string_view, std::span<const byte>>;
+
+	template <std::ranges::viewable_range R>
+		requires std::ranges::forward_range<R> && element_of<std::ranges::range_reference_t<R>, element>
+	auto operator()(R &&r) const {
+		return batch_view<std::views::all_t<R>, Decode>(std::views::all(std::forward<R>(r)));
+	}
+
+	template <std::ranges::viewable_range R>
+		requires std::ranges::forward_range<R> && element_of<std::ranges::range_reference_t<R>, element>
+	friend auto operator|(R &&r, const batch_adaptor &self) {
+		return self(std::forward<R>(r));
+	}
+};
+
+} // namespace detail
+
+namespace views {
+
+/**
+ * @brief A range adaptor that lazily encodes a range of byte spans in
+ * Base58Check format.
+ * @details The elements are encoded in groups through
+ * base58check_encode_batch() into one scratch buffer that is reused for the
+ * life of the view, and each element of the view is an encoded_item whose
+ * text refers into that buffer. The view is an input range.
+ */
+inline constexpr detail::batch_adaptor<false> encode;
+
+/**
+ * @brief A range adaptor that lazily decodes a range of Base58Check strings.
+ * @details The elements are decoded in groups through
+ * base58check_decode_batch() into one scratch buffer that is reused for the
+ * life of the view, and each element of the view is a decoded_item whose data
+ * refer into that buffer. An element that fails to decode is reported in its
+ * item's error rather than by an exception. The view is an input range.
+ */
+inline constexpr detail::batch_adaptor<true> decode;
+
+} // namespace views
+
+namespace detail {
+
+// a straightforward SHA-256 for use in constant expressions
+static constexpr std::array<std::uint8_t, 32> sha256(const std::uint8_t in[], size_t n_in) noexcept {
+	constexpr std::uint32_t k[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+	auto rotr = [](std::uint32_t x, unsigned n) { return x >> n | x << (32 - n); };
+	std::uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+	size_t n_blocks = (n_in + 9 + 63) / 64;
+	for (size_t b = 0; b < n_blocks; ++b) {
+		std::uint32_t w[64] = { };
+		for (size_t i = 0; i < 64; ++i) {
+			size_t j = b * 64 + i;
+			std::uint8_t c = j < n_in ? in[j] : j == n_in ? 0x80 : 0;
+			if (b == n_blocks - 1 && i >= 56)
+				c = static_cast<std::uint8_t>(static_cast<std::uint64_t>(n_in) * 8 >> (63 - i) * 8);
+			w[i / 4] |= std::uint32_t(c) << (3 - i % 4) * 8;
+		}
+		for (size_t t = 16; t < 64; ++t)
+			w[t] = w[t - 16] + (rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3)) +
+				w[t - 7] + (rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10));
+		std::uint32_t v[8] = { h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7] };
+		for (size_t t = 0; t < 64; ++t) {
+			std::uint32_t t1 = v[7] + (rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) + k[t] + w[t],
+					t2 = (rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+			for (size_t i = 7; i > 0; --i)
+				v[i] = v[i - 1];
+			v[4] += t1, v[0] = t1 + t2;
+		}
+		for (size_t i = 0; i < 8; ++i)
+			h[i] += v[i];
+	}
+	std::array<std::uint8_t, 32> ret { };
+	for (size_t i = 0; i < 32; ++i)
+		ret[i] = static_cast<std::uint8_t>(h[i / 4] >> (3 - i % 4) * 8);
+	return ret;
+}
+
+// the first 4 bytes of the double SHA-256 hash, in a constant expression
+static constexpr std::array<std::uint8_t, 4> checksum(const std::uint8_t in[], size_t n_in) noexcept {
+	auto hash = sha256(in, n_in);
+	hash = sha256(hash.data(), hash.size());
+	return { hash[0], hash[1], hash[2], hash[3] };
+}
+
+// A string literal as a template argument. N counts the terminator.
+template <size_t N>
+struct literal {
+	char chars[N];
+
+	consteval literal(const char (&str)[N]) noexcept : chars() {
+		for (size_t i = 0; i < N; ++i)
+			chars[i] = str[i];
+	}
+};
+
+// The decoding of a Base58Check literal, with its checksum verified, at the
+// front of bytes. Invalid literals fail to be constant expressions, which
+// makes them compile errors.
+template <size_t N>
+struct literal_decoding {
+	std::array<std::uint8_t, N> bytes { };
+	size_t size = 0;
+
+	consteval literal_decoding(const literal<N> &str) {
+		constexpr size_t n_in = N - 1;
+		size_t n_leading_zeros = 0;
+		while (n_leading_zeros < n_in && str.chars[n_leading_zeros] == '1')
+			++n_leading_zeros;
+		// the value, big-endian, in the bytes after the leading zeros
+		std::uint8_t value[N] = { };
+		for (size_t i = n_leading_zeros; i < n_in; ++i) {
+			std::int8_t digit = digit_of(str.chars[i]);
+			if (digit < 0)
+				throw std::invalid_argument("Base58Check literal contains an illegal character");
+			unsigned carry = static_cast<std::uint8_t>(digit);
+			for (size_t j = N; j-- > 0;) {
+				carry += value[j] * 58u;
+				value[j] = static_cast<std::uint8_t>(carry);
+				carry >>= 8;
+			}
+		}
+		size_t first = 0;
+		while (first < N && !value[first])
+			++first;
+		size = n_leading_zeros + (N - first);
+		if (size < 4)
+			throw std::invalid_argument("Base58Check literal is too short");
+		for (size_t i = 0; i < N - first; ++i)
+			bytes[n_leading_zeros + i] = value[first + i];
+		size -= 4;
+		auto check = checksum(bytes.data(), size);
+		for (size_t i = 0; i < 4; ++i)
+			if (bytes[size + i] != check[i])
+				throw std::invalid_argument("Base58Check literal has a checksum mismatch");
+	}
+};
+
+} // namespace detail
+
+/**
+ * @brief Encodes fixed-size data in Base58Check format in a constant
+ * expression.
+ * @details The result is the same as that of fixed_encoder<N>::encode(), which
+ * is much faster at run time.
+ * @param in The data to be encoded.
+ * @return The encoding.
+ */
+template <size_t N>
+static constexpr typename fixed_encoder<N>::result encode_constant(const std::array<byte, N> &in) noexcept {
+	std::uint8_t value[N + 4] = { };
+	for (size_t i = 0; i < N; ++i)
+		value[i] = static_cast<std::uint8_t>(in[i]);
+	auto check = detail::checksum(value, N);
+	for (size_t i = 0; i < 4; ++i)
+		value[N + i] = check[i];
+
+	typename fixed_encoder<N>::result ret { };
+	size_t n_leading_zeros = 0;
+	while (n_leading_zeros < N && !value[n_leading_zeros])
+		ret.chars[n_leading_zeros++] = '1';
+	size_t pos = detail::divide_digits(ret.chars.data(), ret.chars.size(), value, N + 4);
+	for (size_t i = pos; i < ret.chars.size(); ++i)
+		ret.chars[n_leading_zeros + (i - pos)] = ret.chars[i];
+	ret.size = n_leading_zeros + (ret.chars.size() - pos);
+	return ret;
+}
+
+#if __cpp_consteval >= 201811L && __cpp_nontype_template_args >= 201911L
+
+/**
+ * @brief Decodes a Base58Check string literal at compile time.
+ * @details A literal that contains an illegal character, is too short, or has
+ * a checksum mismatch is a compile error.
+ * @tparam S The Base58Check encoding to be decoded.
+ * @return The decoded data.
+ */
+template <detail::literal S>
+static consteval auto decode_constant() {
+	constexpr detail::literal_decoding decoding(S);
+	std::array<byte, decoding.size> ret { };
+	for (size_t i = 0; i < ret.size(); ++i)
+		ret[i] = static_cast<byte>(decoding.bytes[i]);
+	return ret;
+}
+
+inline namespace literals {
+
+/**
+ * @brief Decodes a Base58Check string literal at compile time.
+ * @details For example, <tt>"1BitcoinEaterAddressDontSendf59kuE"_b58c</tt> is
+ * a <tt>std::array<base58check::byte, 21></tt>. See decode_constant().
+ */
+template <detail::literal S>
+consteval auto operator ""_b58c() {
+	return decode_constant<S>();
+}
+
+} // inline namespace literals
+
+#endif // __cpp_consteval >= 201811L && __cpp_nontype_template_args >= 201911L
+
 #endif // __cplusplus >= 202002L
 
 #endif // __cplusplus >= 201703L
@@ -0,0 +1,142 @@
+#include "base58check.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// Every allocation made by the library goes through this replacement of its
+// weak hook, so the allocations per operation can be counted.
+static unsigned long n_allocs;
+
+extern "C" void * base58check_malloc(size_t size) {
+	++n_allocs;
+	return std::malloc(size);
+}
+
+extern "C" void base58check_free(void *ptr) {
+	std::free(ptr);
+}
+
+static volatile size_t sink;
+
+struct result {
+	const char *op, *api, *input;
+	size_t size;
+	unsigned long iterations;
+	double ns_per_op, mb_per_s, allocs_per_op;
+};
+
+static std::vector<result> results;
+static double min_seconds = 0.25;
+
+// Runs f in batches of doubling size until a batch takes at least
+// min_seconds, and records the per-call figures of that batch.
+template <typename F>
+static void measure(const char *op, const char *api, const char *input, size_t size, F f) {
+	using clock = std::chrono::steady_clock;
+	f(); // warm up the caches and the library's lazily computed tables
+	for (unsigned long n = 1;; n *= 2) {
+		unsigned long allocs = n_allocs;
+		auto start = clock::now();
+		for (unsigned long i = 0; i < n; ++i)
+			f();
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+		if (seconds >= min_seconds || n >= 1UL << 30) {
+			double ns = seconds * 1e9 / static_cast<double>(n);
+			results.push_back({ op, api, input, size, n, ns, static_cast<double>(size) * 1e3 / ns,
+				static_cast<double>(n_allocs - allocs) / static_cast<double>(n) });
+			std::fprintf(stderr, "%-7s %-4s %-13s %8zu B %14.1f ns/op\n", op, api, input, size, ns);
+			return;
+		}
+	}
+}
+
+static void bench_encode(const char *input, const std::vector<base58check::byte> &payload) {
+	const base58check::byte *data = payload.data();
+	size_t n = payload.size();
+	measure("encode", "c", input, n, [&] {
+		char *out = nullptr;
+		size_t n_out = 0;
+		if (::base58check_encode(&out, &n_out, reinterpret_cast<const unsigned char *>(data), n, 0) < 0)
+			throw std::runtime_error("encode failed");
+		sink = sink + n_out;
+		::base58check_free(out);
+	});
+	measure("encode", "c++", input, n, [&] {
+		sink = sink + base58check::encode(data, n).size();
+	});
+}
+
+static void bench_decode(const char *input, size_t size, const std::string &encoding, int expect) {
+	measure("decode", "c", input, size, [&] {
+		unsigned char *out = nullptr;
+		size_t n_out = 0;
+		if (::base58check_decode(&out, &n_out, encoding.data(), encoding.size(), 0) != expect)
+			throw std::runtime_error("decode gave an unexpected result");
+		if (!expect) {
+			sink = sink + n_out;
+			::base58check_free(out);
+		}
+	});
+	measure("decode", "c++", input, size, [&] {
+		try {
+			sink = sink + base58check::decode(encoding.data(), encoding.size()).size();
+		}
+		catch (const std::invalid_argument &) {
+			if (!expect)
+				throw;
+		}
+	});
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 2 || (argc == 2 && !((min_seconds = std::strtod(argv[1], nullptr)) > 0))) {
+		std::fprintf(stderr, "usage: %s [min-seconds]\n\n"
+			"Times the encoding and decoding of a range of payloads, running each case for\n"
+			"at least min-seconds (default 0.25), and writes the results as JSON to stdout.\n",
+			argv[0]);
+		return 64;
+	}
+
+	static const size_t sizes[] = { 1, 21, 25, 34, 78, 1024, 65536, 1048576 };
+	std::mt19937 rng(58);
+	for (size_t size : sizes) {
+		std::vector<base58check::byte> payload(size), zeros(size);
+		for (auto &b : payload)
+			b = static_cast<base58check::byte>(rng() | 1);
+		// three quarters leading zeros, which encode as runs of '1'
+		for (size_t i = size - size / 4; i < size; ++i)
+			zeros[i] = payload[i];
+
+		bench_encode("random", payload);
+		bench_encode("leading-zeros", zeros);
+
+		const base58check::byte *data = payload.data();
+		std::string encoding = base58check::encode(data, size);
+		bench_decode("random", size, encoding, 0);
+		data = zeros.data();
+		bench_decode("leading-zeros", size, base58check::encode(data, size), 0);
+
+		std::string bad_char = encoding, bad_checksum = encoding;
+		bad_char[bad_char.size() / 2] = '0';
+		bad_checksum.back() = bad_checksum.back() == '2' ? '3' : '2';
+		bench_decode("bad-char", size, bad_char, BASE58CHECK_ECHAR);
+		bench_decode("bad-checksum", size, bad_checksum, BASE58CHECK_ECHECKSUM);
+	}
+
+	std::printf("{\n\t\"version\": \"%s\",\n\t\"min_seconds\": %g,\n\t\"results\": [", VERSION, min_seconds);
+	for (size_t i = 0; i < results.size(); ++i) {
+		const result &r = results[i];
+		std::printf("%s\n\t\t{ \"op\": \"%s\", \"api\": \"%s\", \"input\": \"%s\", \"size\": %zu, \"iterations\": %lu, "
+			"\"ns_per_op\": %.1f, \"mb_per_s\": %.3f, \"allocs_per_op\": %.2f }",
+			i ? "," : "", r.op, r.api, r.input, r.size, r.iterations, r.ns_per_op, r.mb_per_s, r.allocs_per_op);
+	}
+	std::printf("\n\t]\n}\n");
+	return 0;
+}
@@ -1,21 +1,146 @@
 #include "base58check.h"
+#include "sha256.h"
 
 #include <assert.h>
-#include <gmp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
 #include <openssl/sha.h>
 
+#ifdef ENABLE_STATS
+# ifdef HAVE_SYS_SDT_H
+#  include <sys/sdt.h>
+# else
+#  define DTRACE_PROBE3(provider, name, arg1, arg2, arg3) ((void) 0)
+# endif
+#endif
+
+// Without GMP, numbers of every size are converted by the native basecase,
+// whose cost is quadratic in their length.
+#ifdef NO_GMP
+# ifdef __SIZEOF_INT128__
+typedef uint64_t mp_limb_t;
+#  define GMP_LIMB_BITS 64
+# else
+typedef uint32_t mp_limb_t;
+#  define GMP_LIMB_BITS 32
+# endif
+typedef long mp_size_t;
+#else
+# include <gmp.h>
+#endif
+
 #if GMP_LIMB_BITS < 32 || GMP_LIMB_BITS > 64
 # error "unsupported limb size"
 #endif
 
 #define MP_NLIMBS(n) (((n) + sizeof(mp_limb_t) - 1) / sizeof(mp_limb_t))
 
+#if GMP_LIMB_BITS == 64
+# define LIMB_DIGITS 10
+# define LIMB_BASE UINT64_C(430804206899405824) /* 58**10 */
+#elif GMP_LIMB_BITS == 32
+# define LIMB_DIGITS 5
+# define LIMB_BASE 656356768 /* 58**5 */
+#endif
+
+// Numbers of up to NATIVE_THRESHOLD limbs are divided and multiplied by
+// LIMB_BASE with inline double-limb arithmetic, as the call overhead of GMP's
+// single-limb routines dominates at those sizes.
+#ifndef NATIVE_THRESHOLD
+# define NATIVE_THRESHOLD 16 /* limbs */
+#endif
+#if GMP_LIMB_BITS == 64 && defined(__SIZEOF_INT128__)
+typedef unsigned __int128 dlimb_t;
+// LIMB_BASE is normalized by shifting it left LIMB_BASE_SHIFT bits, and
+// LIMB_BASE_INV is floor((2**128 - 1) / (LIMB_BASE << LIMB_BASE_SHIFT)) - 2**64
+# define LIMB_BASE_SHIFT 5
+# define LIMB_BASE_INV UINT64_C(0x568df8b76cbf212c)
+#elif GMP_LIMB_BITS == 32
+typedef uint64_t dlimb_t;
+// LIMB_BASE_INV is floor((2**64 - 1) / (LIMB_BASE << LIMB_BASE_SHIFT)) - 2**32
+# define LIMB_BASE_SHIFT 2
+# define LIMB_BASE_INV UINT32_C(0xa2cb1eb4)
+#endif
+
+// sizes at and above which base conversion switches to divide and conquer
+#ifndef DC_ENCODE_THRESHOLD
+# define DC_ENCODE_THRESHOLD 32 /* limbs */
+#endif
+#ifndef DC_DECODE_THRESHOLD
+# define DC_DECODE_THRESHOLD 800 /* digits */
+#endif
+
+// an upper bound on the number of limbs needed to hold a number of d digits;
+// 5858/1000 approximates log2(58) from above
+#define DC_LIMBS_FOR_DIGITS(d) ((d) * 5858 / (GMP_LIMB_BITS * 1000) + 4)
+
 #define _likely(...) __builtin_expect(!!(__VA_ARGS__), 1)
 #define _unlikely(...) __builtin_expect(!!(__VA_ARGS__), 0)
 
+// number of consecutive candidates that a search thread claims at a time
+#define SEARCH_BLOCK 4096
+
+// number of batch items whose checksums are computed ahead of their base conversions
+#define BATCH_GROUP 16
+
+// number of encodings that an address set decodes per batch while being built
+#define SET_BATCH 4096
+
+// the header of an address set image: a magic number whose last byte is the
+// format version, then the payload size, the number of payloads, the number
+// of slots (a power of two), and the seed of the hash, each a little-endian
+// 64-bit word, then reserved zeros
+#define SET_MAGIC "B58CSET\1"
+#define SET_HEADER_SIZE 64
+
+// the header of a pack: a magic number whose last byte is the format version,
+// then the number of records, the size of each record if they are all the
+// same size, the flags, the size of the records, and the offset of the index
+// or 0 if there is none, each a little-endian 64-bit word, then reserved zeros
+#define PACK_MAGIC "B58CPAK\1"
+#define PACK_HEADER_SIZE 64
+#define PACK_VARIABLE (1 << 0) // records are prefixed by their sizes
+#define PACK_INDEXED (1 << 1)
+
+// number of records that an unpacking thread claims at a time
+#define UNPACK_RUN 4096
+
+// The alphabet is checked, and digits are paired up, SCAN_WIDTH bytes at a
+// time in SIMD vectors. On x86 the vector code is compiled for SSE4.1 and AVX2
+// too and picked for the running CPU.
+#define SCAN_WIDTH 32
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__has_attribute)
+# if __has_attribute(__target_clones__)
+#  define _simd_clones __attribute__ ((__target_clones__ ("avx2", "sse4.1", "default")))
+# endif
+#endif
+#ifndef _simd_clones
+# define _simd_clones
+#endif
+
+// number of characters whose digits the decoding basecase maps and packs at once
+#define DECODE_BLOCK (LIMB_DIGITS * 64)
+
+// largest payload, including its checksum, whose scratch space is staged on
+// the stack rather than the heap by base58check_verify(), the prefix encoder,
+// and calls made without a context; 256 bytes covers encodings of up to 349
+// characters
+#define STACK_PAYLOAD_SIZE BASE58CHECK_STACK_PAYLOAD_SIZE
+
+// an upper bound on the number of base-LIMB_BASE digits of an n-byte number
+#define BIG_DIGITS_FOR_BYTES(n) ((n) * 8 / (LIMB_DIGITS * 5857 / 1000) + 1)
+
 
 static inline size_t encoded_size_upper_bound(size_t n) {
 	// 1430893/1047768 approximates log(256)/log(58) with error +9.950928969715278e-12
@@ -145,13 +270,211 @@ static void limbs_to_bytes(uint8_t *restrict bytes, const mp_limb_t *restrict li
 	}
 }
 
-static size_t encode_limbs(char *restrict out, size_t n_out, mp_limb_t *restrict limbs, mp_size_t n_limbs) {
-	static const char encode[58] = {
-		'1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
-		'H', 'J', 'K', 'L', 'M', 'N', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y',
-		'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'm', 'n', 'o', 'p',
-		'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z'
-	};
+static const char encode[58] = {
+	'1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F', 'G',
+	'H', 'J', 'K', 'L', 'M', 'N', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y',
+	'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'm', 'n', 'o', 'p',
+	'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z'
+};
+
+// the two characters of each base-58**2 digit, so that digits are emitted in
+// pairs
+#define ENCODE_PAIR_ROW(c) \
+	{ c, '1' }, { c, '2' }, { c, '3' }, { c, '4' }, { c, '5' }, { c, '6' }, { c, '7' }, { c, '8' }, \
+	{ c, '9' }, { c, 'A' }, { c, 'B' }, { c, 'C' }, { c, 'D' }, { c, 'E' }, { c, 'F' }, { c, 'G' }, \
+	{ c, 'H' }, { c, 'J' }, { c, 'K' }, { c, 'L' }, { c, 'M' }, { c, 'N' }, { c, 'P' }, { c, 'Q' }, \
+	{ c, 'R' }, { c, 'S' }, { c, 'T' }, { c, 'U' }, { c, 'V' }, { c, 'W' }, { c, 'X' }, { c, 'Y' }, \
+	{ c, 'Z' }, { c, 'a' }, { c, 'b' }, { c, 'c' }, { c, 'd' }, { c, 'e' }, { c, 'f' }, { c, 'g' }, \
+	{ c, 'h' }, { c, 'i' }, { c, 'j' }, { c, 'k' }, { c, 'm' }, { c, 'n' }, { c, 'o' }, { c, 'p' }, \
+	{ c, 'q' }, { c, 'r' }, { c, 's' }, { c, 't' }, { c, 'u' }, { c, 'v' }, { c, 'w' }, { c, 'x' }, \
+	{ c, 'y' }, { c, 'z' }
+static const char encode_pairs[58 * 58][2] = {
+	ENCODE_PAIR_ROW('1'), ENCODE_PAIR_ROW('2'), ENCODE_PAIR_ROW('3'), ENCODE_PAIR_ROW('4'),
+	ENCODE_PAIR_ROW('5'), ENCODE_PAIR_ROW('6'), ENCODE_PAIR_ROW('7'), ENCODE_PAIR_ROW('8'),
+	ENCODE_PAIR_ROW('9'), ENCODE_PAIR_ROW('A'), ENCODE_PAIR_ROW('B'), ENCODE_PAIR_ROW('C'),
+	ENCODE_PAIR_ROW('D'), ENCODE_PAIR_ROW('E'), ENCODE_PAIR_ROW('F'), ENCODE_PAIR_ROW('G'),
+	ENCODE_PAIR_ROW('H'), ENCODE_PAIR_ROW('J'), ENCODE_PAIR_ROW('K'), ENCODE_PAIR_ROW('L'),
+	ENCODE_PAIR_ROW('M'), ENCODE_PAIR_ROW('N'), ENCODE_PAIR_ROW('P'), ENCODE_PAIR_ROW('Q'),
+	ENCODE_PAIR_ROW('R'), ENCODE_PAIR_ROW('S'), ENCODE_PAIR_ROW('T'), ENCODE_PAIR_ROW('U'),
+	ENCODE_PAIR_ROW('V'), ENCODE_PAIR_ROW('W'), ENCODE_PAIR_ROW('X'), ENCODE_PAIR_ROW('Y'),
+	ENCODE_PAIR_ROW('Z'), ENCODE_PAIR_ROW('a'), ENCODE_PAIR_ROW('b'), ENCODE_PAIR_ROW('c'),
+	ENCODE_PAIR_ROW('d'), ENCODE_PAIR_ROW('e'), ENCODE_PAIR_ROW('f'), ENCODE_PAIR_ROW('g'),
+	ENCODE_PAIR_ROW('h'), ENCODE_PAIR_ROW('i'), ENCODE_PAIR_ROW('j'), ENCODE_PAIR_ROW('k'),
+	ENCODE_PAIR_ROW('m'), ENCODE_PAIR_ROW('n'), ENCODE_PAIR_ROW('o'), ENCODE_PAIR_ROW('p'),
+	ENCODE_PAIR_ROW('q'), ENCODE_PAIR_ROW('r'), ENCODE_PAIR_ROW('s'), ENCODE_PAIR_ROW('t'),
+	ENCODE_PAIR_ROW('u'), ENCODE_PAIR_ROW('v'), ENCODE_PAIR_ROW('w'), ENCODE_PAIR_ROW('x'),
+	ENCODE_PAIR_ROW('y'), ENCODE_PAIR_ROW('z')
+};
+#undef ENCODE_PAIR_ROW
+
+// Writes the 5 characters of d < 58**5, most significant first.
+static inline void five_to_chars(char out[5], uint32_t d) {
+	uint32_t r = d % (58 * 58 * 58 * 58);
+	out[0] = encode[d / (58 * 58 * 58 * 58)];
+	memcpy(out + 1, encode_pairs[r / (58 * 58)], 2);
+	memcpy(out + 3, encode_pairs[r % (58 * 58)], 2);
+}
+
+// Writes the LIMB_DIGITS characters of the base-LIMB_BASE digit d, most
+// significant first.
+static inline void limb_to_chars(char out[LIMB_DIGITS], mp_limb_t d) {
+#if LIMB_DIGITS == 10
+	five_to_chars(out, (uint32_t) (d / 656356768 /* 58**5 */));
+	five_to_chars(out + 5, (uint32_t) (d % 656356768));
+#else
+	five_to_chars(out, (uint32_t) d);
+#endif
+}
+
+#ifdef LIMB_BASE_INV
+// Divides (*r * LIMB_BASE + u) by LIMB_BASE, where *r < LIMB_BASE, by
+// Möller-Granlund multiplication by the precomputed reciprocal. Returns the
+// quotient and replaces *r with the remainder.
+static inline mp_limb_t native_divrem(mp_limb_t *r, mp_limb_t u) {
+	const mp_limb_t norm = (mp_limb_t) LIMB_BASE << LIMB_BASE_SHIFT;
+	mp_limb_t n1 = *r << LIMB_BASE_SHIFT | u >> (GMP_LIMB_BITS - LIMB_BASE_SHIFT), n0 = u << LIMB_BASE_SHIFT;
+	dlimb_t p = (dlimb_t) LIMB_BASE_INV * n1 + ((dlimb_t) n1 << GMP_LIMB_BITS | n0);
+	mp_limb_t q = (mp_limb_t) (p >> GMP_LIMB_BITS) + 1, rem = n0 - q * norm;
+	if (rem > (mp_limb_t) p)
+		--q, rem += norm;
+	if (_unlikely(rem >= norm))
+		++q, rem -= norm;
+	*r = rem >> LIMB_BASE_SHIFT;
+	return q;
+}
+#endif
+
+// Divides limbs[0..n_limbs) in place by LIMB_BASE and returns the remainder.
+static inline mp_limb_t limbs_divrem_base(mp_limb_t *limbs, mp_size_t n_limbs) {
+#ifndef NO_GMP
+# ifdef LIMB_BASE_INV
+	if (n_limbs > NATIVE_THRESHOLD)
+# endif
+		return mpn_divrem_1(limbs, 0, limbs, n_limbs, LIMB_BASE);
+#endif
+#ifdef LIMB_BASE_INV
+	mp_limb_t r = 0;
+	while (n_limbs--)
+		limbs[n_limbs] = native_divrem(&r, limbs[n_limbs]);
+	return r;
+#endif
+}
+
+// Multiplies limbs[0..n_limbs) in place by LIMB_BASE and adds addend. Returns
+// the limb carried out, which never overflows.
+static inline mp_limb_t limbs_mul_add_base(mp_limb_t *limbs, mp_size_t n_limbs, mp_limb_t addend) {
+#ifndef NO_GMP
+# ifdef LIMB_BASE_INV
+	if (n_limbs > NATIVE_THRESHOLD)
+# endif
+		return mpn_mul_1(limbs, limbs, n_limbs, LIMB_BASE) + mpn_add_1(limbs, limbs, n_limbs, addend);
+#endif
+#ifdef LIMB_BASE_INV
+	for (mp_size_t i = 0; i < n_limbs; ++i) {
+		dlimb_t t = (dlimb_t) limbs[i] * LIMB_BASE + addend;
+		limbs[i] = (mp_limb_t) t, addend = (mp_limb_t) (t >> GMP_LIMB_BITS);
+	}
+	return addend;
+#endif
+}
+
+#ifndef NO_GMP
+
+// The powers 58**(LIMB_DIGITS * 2**k) used by the divide-and-conquer base
+// conversions. Each is computed on first use by squaring its predecessor and
+// is then kept for the life of the process.
+struct dc_power {
+	mp_size_t n_limbs;
+	mp_limb_t limbs[];
+};
+
+static const struct dc_power * dc_power(unsigned k) {
+	static const struct dc_power *powers[GMP_LIMB_BITS];
+	const struct dc_power *power = __atomic_load_n(&powers[k], __ATOMIC_ACQUIRE);
+	if (_likely(power))
+		return power;
+	struct dc_power *new_power;
+	if (k == 0) {
+		if (!(new_power = base58check_malloc(sizeof *new_power + sizeof(mp_limb_t))))
+			return NULL;
+		new_power->n_limbs = 1, new_power->limbs[0] = LIMB_BASE;
+	}
+	else {
+		const struct dc_power *root = dc_power(k - 1);
+		if (!root || !(new_power = base58check_malloc(sizeof *new_power + 2 * root->n_limbs * sizeof(mp_limb_t))))
+			return NULL;
+		mpn_sqr(new_power->limbs, root->limbs, root->n_limbs);
+		new_power->n_limbs = 2 * root->n_limbs - (new_power->limbs[2 * root->n_limbs - 1] == 0);
+	}
+	if (!__atomic_compare_exchange_n(&powers[k], &power, new_power, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		base58check_free(new_power); // another thread got there first
+		return power;
+	}
+	return new_power;
+}
+
+// Returns the largest k for which LIMB_DIGITS * 2**k <= n_digits / 2, after
+// making sure that the powers for all k up to it are cached, so that a
+// conversion of n_digits digits cannot fail partway through. Returns -1 upon
+// failure to allocate memory.
+static int dc_prepare(size_t n_digits) {
+	int k_max = 0;
+	while (((size_t) LIMB_DIGITS << (k_max + 1)) <= n_digits / 2)
+		++k_max;
+	for (unsigned k = 0; k <= (unsigned) k_max; ++k)
+		if (!dc_power(k))
+			return -1;
+	return k_max;
+}
+
+// Writes exactly n_digits digit values of {limbs, n_limbs}, which must be less
+// than 58**n_digits, to out, most significant first. Destroys limbs. The
+// number is split by the largest cached power not exceeding its square root,
+// and the quotient and remainder are converted recursively, so the cost is
+// dominated by GMP's subquadratic division. scratch must have room for
+// 4 * n_limbs + 2 * GMP_LIMB_BITS limbs.
+static void dc_encode_digits(uint8_t *restrict out, size_t n_digits, mp_limb_t *restrict limbs, mp_size_t n_limbs, mp_limb_t *restrict scratch, unsigned k) {
+	while (n_limbs && !limbs[n_limbs - 1])
+		--n_limbs;
+	if (n_limbs < DC_ENCODE_THRESHOLD) {
+		uint8_t *p = out + n_digits;
+		while (n_limbs) {
+			mp_limb_t limb = limbs_divrem_base(limbs, n_limbs);
+			n_limbs -= !limbs[n_limbs - 1];
+			for (unsigned i = 0; i < LIMB_DIGITS && p != out; ++i)
+				*--p = (uint8_t) (limb % 58), limb /= 58;
+		}
+		memset(out, 0, p - out);
+		return;
+	}
+	const struct dc_power *power;
+	while ((power = dc_power(k))->n_limbs * 2 > n_limbs)
+		--k;
+	mp_size_t n_quot = n_limbs - power->n_limbs + 1;
+	mp_limb_t *quot = scratch, *rem = scratch + n_quot;
+	mpn_tdiv_qr(quot, rem, 0, limbs, n_limbs, power->limbs, power->n_limbs);
+	size_t n_low = (size_t) LIMB_DIGITS << k;
+	scratch += n_quot + power->n_limbs;
+	dc_encode_digits(out + (n_digits - n_low), n_low, rem, power->n_limbs, scratch, k);
+	dc_encode_digits(out, n_digits - n_low, quot, n_quot, scratch, k);
+}
+
+#endif // !defined(NO_GMP)
+
+static void * default_alloc(void *opaque, size_t size) {
+	(void) opaque;
+	return base58check_malloc(size);
+}
+
+static void default_free(void *opaque, void *ptr, size_t size) {
+	(void) opaque, (void) size;
+	base58check_free(ptr);
+}
+
+// the allocator of everything but contexts made with an allocator of their own
+static const struct base58check_allocator default_allocator = { default_alloc, default_free, NULL };
+
+static size_t encode_limbs(char *restrict out, size_t n_out, mp_limb_t *restrict limbs, mp_size_t n_limbs, const struct base58check_allocator *alloc) {
 	for (;;) {
 		if (!n_limbs)
 			return 0;
@@ -159,23 +482,40 @@ static size_t encode_limbs(char *restrict out, size_t n_out, mp_limb_t *restrict
 			break;
 		--n_limbs;
 	}
+#ifdef NO_GMP
+	(void) alloc;
+#else
+	// payloads small enough to be staged on the stack never take the divide
+	// and conquer path, whose scratch space would have to be allocated
+	if (n_limbs >= DC_ENCODE_THRESHOLD && (size_t) n_limbs > MP_NLIMBS(STACK_PAYLOAD_SIZE)) {
+		size_t n_digits = encoded_size_upper_bound(n_limbs * sizeof(mp_limb_t));
+		if (n_digits > n_out)
+			n_digits = n_out;
+		int k_max = dc_prepare(n_digits);
+		size_t n_scratch = (4 * n_limbs + 2 * GMP_LIMB_BITS) * sizeof(mp_limb_t);
+		mp_limb_t *scratch;
+		if (k_max >= 0 && (scratch = alloc->alloc(alloc->opaque, n_scratch))) {
+			dc_encode_digits((uint8_t *) out, n_digits, limbs, n_limbs, scratch, k_max);
+			alloc->free(alloc->opaque, scratch, n_scratch);
+			size_t first = 0;
+			while (out[first] == 0)
+				++first;
+			for (size_t i = first; i < n_digits; ++i)
+				out[i - first] = encode[(uint8_t) out[i]];
+			return n_digits - first;
+		}
+	}
+#endif
 	char *p = out + n_out;
 	while (limbs[n_limbs - 1] || --n_limbs) {
-#if GMP_LIMB_BITS == 64
-		mp_limb_t limb = mpn_divrem_1(limbs, 0, limbs, n_limbs, UINT64_C(430804206899405824) /* 58**10 */);
-#elif GMP_LIMB_BITS == 32
-		mp_limb_t limb = mpn_divrem_1(limbs, 0, limbs, n_limbs, 656356768 /* 58**5 */);
-#endif
+		mp_limb_t limb = limbs_divrem_base(limbs, n_limbs);
 		if (n_limbs == 1 && *limbs == 0) {
 			while (limb) {
 				*--p = encode[limb % 58], limb /= 58;
 			}
 			break;
 		}
-		size_t n_digits = GMP_LIMB_BITS * 10 / 64;
-		do {
-			*--p = encode[limb % 58], limb /= 58;
-		} while (--n_digits);
+		limb_to_chars(p -= LIMB_DIGITS, limb);
 	}
 	size_t n_ret = out + n_out - p;
 	assert(n_ret <= n_out);
@@ -185,68 +525,324 @@ static size_t encode_limbs(char *restrict out, size_t n_out, mp_limb_t *restrict
 	return n_ret;
 }
 
-static mp_size_t decode_limbs(mp_limb_t *restrict limbs, const char *in, size_t n_in) {
-	static const int8_t decode['z' - '1' + 1] = {
-		 0,  1,  2,  3,  4,  5,  6,  7,  8, -1, -1, -1, -1, -1, -1, -1,
-		 9, 10, 11, 12, 13, 14, 15, 16, -1, 17, 18, 19, 20, 21, -1, 22,
-		23, 24, 25, 26, 27, 28, 29, 30, 31, 32, -1, -1, -1, -1, -1, -1,
-		33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, -1, 44, 45, 46, 47,
-		48, 49, 50, 51, 52, 53, 54, 55, 56, 57
-	};
-	for (;;) {
-		if (!n_in)
-			return 0;
-		if (*in != '1')
-			break;
-		++in, --n_in;
+typedef uint8_t char_vec_t __attribute__ ((__vector_size__ (SCAN_WIDTH)));
+typedef uint16_t pair_vec_t __attribute__ ((__vector_size__ (SCAN_WIDTH)));
+
+// Maps a vector of characters to their digit values. Lanes holding characters
+// outside the alphabet are set in bad.
+static inline __attribute__ ((__always_inline__)) void scan_vec(char_vec_t *restrict digits, char_vec_t *restrict bad, const char_vec_t *restrict c) {
+	// Relative to '1', the alphabet is six runs of consecutive characters,
+	// each of which is offset from its digit values by a constant.
+#define IN_RUN(lo, hi) ((char_vec_t) (d - (lo) <= (hi) - (lo)))
+	char_vec_t d = *c - '1';
+	char_vec_t r1 = IN_RUN(0, 8), r2 = IN_RUN(16, 23), r3 = IN_RUN(25, 29),
+			r4 = IN_RUN(31, 41), r5 = IN_RUN(48, 58), r6 = IN_RUN(60, 73);
+#undef IN_RUN
+	*digits = d - (r2 & 7) - (r3 & 8) - (r4 & 9) - (r5 & 15) - (r6 & 16);
+	*bad |= ~(r1 | r2 | r3 | r4 | r5 | r6);
+}
+
+// Validates in[0..n_in) against the alphabet and, if digits is not null, maps
+// each character to its digit value. Returns the number of leading '1'
+// characters, or SIZE_MAX if any character is not in the alphabet.
+_simd_clones
+static size_t scan_digits(uint8_t *restrict digits, const char *restrict in, size_t n_in) {
+	char_vec_t bad = { }, d;
+	size_t n_leading = 0, i = 0;
+	for (; i + SCAN_WIDTH <= n_in; i += SCAN_WIDTH) {
+		char_vec_t c;
+		memcpy(&c, in + i, SCAN_WIDTH);
+		scan_vec(&d, &bad, &c);
+		if (digits)
+			memcpy(digits + i, &d, SCAN_WIDTH);
+		if (n_leading == i)
+			for (size_t l = 0; l < SCAN_WIDTH && c[l] == '1'; ++l)
+				++n_leading;
 	}
-	mp_size_t n_limbs = 1;
-	*limbs = 0;
-	while (n_in) {
-#if GMP_LIMB_BITS == 64
-		static const mp_limb_t powers[] = {
-			58, 3364, 195112, 11316496, 656356768, UINT64_C(38068692544),
-			UINT64_C(2207984167552), UINT64_C(128063081718016),
-			UINT64_C(7427658739644928), UINT64_C(430804206899405824)
-		};
-#elif GMP_LIMB_BITS == 32
-		static const mp_limb_t powers[] = {
-			58, 3364, 195112, 11316496, 656356768
-		};
+	if (i < n_in) {
+		// the tail is padded out with '1', which is valid and maps to zero
+		char_vec_t c;
+		memset(&c, '1', SCAN_WIDTH);
+		memcpy(&c, in + i, n_in - i);
+		scan_vec(&d, &bad, &c);
+		if (digits)
+			memcpy(digits + i, &d, n_in - i);
+		if (n_leading == i)
+			for (size_t l = 0; l < n_in - i && c[l] == '1'; ++l)
+				++n_leading;
+	}
+	uint8_t any = 0;
+	for (size_t l = 0; l < SCAN_WIDTH; ++l)
+		any |= bad[l];
+	return _likely(!any) ? n_leading : SIZE_MAX;
+}
+
+// Packs each run of LIMB_DIGITS digits into the limb it denotes. Where runs
+// are of even length, adjacent digits are first combined into base-58**2
+// digits a whole vector at a time, halving the serial multiply-adds per limb.
+_simd_clones
+static void pack_digits(mp_limb_t *restrict limbs, const uint8_t *restrict digits, size_t n_limbs) {
+#if LIMB_DIGITS % 2 == 0
+	uint16_t pairs[DECODE_BLOCK / 2];
+	size_t n_pairs = n_limbs * (LIMB_DIGITS / 2), i = 0;
+	for (; i + SCAN_WIDTH / 2 <= n_pairs; i += SCAN_WIDTH / 2) {
+		pair_vec_t v;
+		memcpy(&v, digits + i * 2, sizeof v);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		v = (v & 0xFF) * 58 + (v >> 8);
+#else
+		v = (v >> 8) * 58 + (v & 0xFF);
 #endif
-		size_t n_digits = sizeof powers / sizeof *powers;
-		if (n_digits > n_in)
-			n_digits = n_in;
-		n_in -= n_digits;
-		mp_limb_t carry = mpn_mul_1(limbs, limbs, n_limbs, powers[n_digits - 1]);
-		if (carry)
-			limbs[n_limbs++] = carry;
+		memcpy(pairs + i, &v, sizeof v);
+	}
+	for (; i < n_pairs; ++i)
+		pairs[i] = (uint16_t) (digits[i * 2] * 58 + digits[i * 2 + 1]);
+	for (i = 0; i < n_limbs; ++i) {
+		const uint16_t *p = pairs + i * (LIMB_DIGITS / 2);
+		mp_limb_t limb = 0;
+		for (size_t j = 0; j < LIMB_DIGITS / 2; ++j)
+			limb = limb * (58 * 58) + p[j];
+		limbs[i] = limb;
+	}
+#else
+	for (size_t i = 0; i < n_limbs; ++i) {
+		const uint8_t *p = digits + i * LIMB_DIGITS;
 		mp_limb_t limb = 0;
-		do {
-			unsigned digit = (uint8_t) (*in++) - '1';
-			if (digit > 'z' - '1' || (signed) (digit = decode[digit]) < 0)
-				return -1;
-			limb = limb * 58 + digit;
-		} while (--n_digits);
-		if (mpn_add_1(limbs, limbs, n_limbs, limb))
-			limbs[n_limbs++] = 1;
+		for (size_t j = 0; j < LIMB_DIGITS; ++j)
+			limb = limb * 58 + p[j];
+		limbs[i] = limb;
+	}
+#endif
+}
+
+// Multiplies {limbs, n_limbs} by 58**n_in and adds the value of the digits at
+// in, which must already have been validated by scan_digits and must number a
+// multiple of LIMB_DIGITS. Each block of characters is mapped to digits before
+// the limbs grow, so the limbs may overlap characters already consumed.
+static mp_size_t decode_limbs_more(mp_limb_t *limbs, mp_size_t n_limbs, const char *in, size_t n_in) {
+	uint8_t digits[DECODE_BLOCK];
+	mp_limb_t chunk[DECODE_BLOCK / LIMB_DIGITS];
+	while (n_in) {
+		size_t n_block = n_in < DECODE_BLOCK ? n_in : DECODE_BLOCK, n_chunk = n_block / LIMB_DIGITS;
+		scan_digits(digits, in, n_block);
+		pack_digits(chunk, digits, n_chunk);
+		for (size_t i = 0; i < n_chunk; ++i) {
+			mp_limb_t carry = limbs_mul_add_base(limbs, n_limbs, chunk[i]);
+			if (carry)
+				limbs[n_limbs++] = carry;
+		}
+		in += n_block, n_in -= n_block;
 	}
 	return n_limbs;
 }
 
+// Computes into limbs the value of the digits at in, which must already have
+// been validated by scan_digits.
+static mp_size_t decode_limbs_basecase(mp_limb_t *restrict limbs, const char *in, size_t n_in) {
+	while (n_in && *in == '1')
+		++in, --n_in;
+	if (!n_in)
+		return 0;
+	uint8_t digits[LIMB_DIGITS];
+
+	// the first limb takes the odd digits so that all the rest are whole
+	size_t n_digits = (n_in - 1) % LIMB_DIGITS + 1;
+	scan_digits(digits, in, n_digits);
+	mp_limb_t limb = 0;
+	for (size_t j = 0; j < n_digits; ++j)
+		limb = limb * 58 + digits[j];
+	*limbs = limb;
+	return decode_limbs_more(limbs, 1, in + n_digits, n_in - n_digits);
+}
+
+#ifndef NO_GMP
 
-size_t base58check_encode_buffer_size(const unsigned char in[], size_t n_in, size_t n_pad) {
+// Computes into out, which must have room for DC_LIMBS_FOR_DIGITS(n_in) limbs,
+// the value of the digits at in by splitting off the low LIMB_DIGITS * 2**k
+// digits, converting both parts recursively, and recombining them with GMP's
+// subquadratic multiplication. scratch must have room for
+// 4 * DC_LIMBS_FOR_DIGITS(n_in) + 8 * GMP_LIMB_BITS limbs. Unless n_in is
+// below DC_DECODE_THRESHOLD, out is not written until in has been read, so the
+// two may overlap.
+static mp_size_t dc_decode_limbs(mp_limb_t *out, const char *in, size_t n_in, mp_limb_t *restrict scratch, unsigned k) {
+	if (n_in < DC_DECODE_THRESHOLD)
+		return decode_limbs_basecase(out, in, n_in);
+	while (k && ((size_t) LIMB_DIGITS << k) > n_in / 2)
+		--k;
+	size_t n_low = (size_t) LIMB_DIGITS << k, n_high = n_in - n_low;
+	mp_limb_t *high = scratch, *low = high + DC_LIMBS_FOR_DIGITS(n_high);
+	scratch = low + DC_LIMBS_FOR_DIGITS(n_low);
+	mp_size_t n_hi = dc_decode_limbs(high, in, n_high, scratch, k),
+			n_lo = dc_decode_limbs(low, in + n_high, n_low, scratch, k);
+	if (!n_hi) {
+		memcpy(out, low, n_lo * sizeof(mp_limb_t));
+		return n_lo;
+	}
+	const struct dc_power *power = dc_power(k);
+	if (n_hi >= power->n_limbs)
+		mpn_mul(out, high, n_hi, power->limbs, power->n_limbs);
+	else
+		mpn_mul(out, power->limbs, power->n_limbs, high, n_hi);
+	mp_size_t n_limbs = n_hi + power->n_limbs;
+	if (n_lo && mpn_add(out, out, n_limbs, low, n_lo))
+		out[n_limbs++] = 1;
+	while (!out[n_limbs - 1])
+		--n_limbs;
+	return n_limbs;
+}
+
+#endif // !defined(NO_GMP)
+
+static mp_size_t decode_limbs(mp_limb_t *restrict limbs, const char *in, size_t n_in, const struct base58check_allocator *alloc) {
+#ifdef NO_GMP
+	(void) alloc;
+#else
+	if (n_in >= DC_DECODE_THRESHOLD) {
+		int k_max = dc_prepare(n_in);
+		size_t n_out = DC_LIMBS_FOR_DIGITS(n_in), n_scratch = (5 * n_out + 8 * GMP_LIMB_BITS) * sizeof(mp_limb_t);
+		mp_limb_t *scratch;
+		if (k_max >= 0 && (scratch = alloc->alloc(alloc->opaque, n_scratch))) {
+			mp_size_t n_limbs = dc_decode_limbs(scratch, in, n_in, scratch + n_out, k_max);
+			memcpy(limbs, scratch, n_limbs * sizeof(mp_limb_t));
+			alloc->free(alloc->opaque, scratch, n_scratch);
+			return n_limbs;
+		}
+	}
+#endif
+	return decode_limbs_basecase(limbs, in, n_in);
+}
+
+// Rewrites {limbs, n_limbs} as the big-endian bytes of the same number, which
+// occupy the same memory.
+static void limbs_to_bytes_inplace(mp_limb_t *limbs, size_t n_limbs) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ && GMP_LIMB_BITS == 64
+# define LIMB_TO_BE(limb) __builtin_bswap64(limb)
+#elif __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+# define LIMB_TO_BE(limb) __builtin_bswap32(limb)
+#else
+# define LIMB_TO_BE(limb) (limb)
+#endif
+	size_t i = 0, j = n_limbs;
+	for (; i + 1 < j; ++i) {
+		mp_limb_t limb = LIMB_TO_BE(limbs[i]);
+		limbs[i] = LIMB_TO_BE(limbs[--j]);
+		limbs[j] = limb;
+	}
+	if (i < j)
+		limbs[i] = LIMB_TO_BE(limbs[i]);
+#undef LIMB_TO_BE
+}
+
+// Encodes in[0..n_in) followed by a 4-byte checksum, or by nothing if checksum
+// is null. The output buffer must be large enough to hold the worst-case
+// encoding, which is also large enough to stage the input plus checksum, and
+// limbs must have room for MP_NLIMBS(n_in + 4). Scratch space for large inputs
+// comes from alloc.
+static size_t encode_payload(char *restrict out, size_t n_out, const unsigned char *restrict in, size_t n_in, const unsigned char *restrict checksum, mp_limb_t *restrict limbs, const struct base58check_allocator *alloc) {
+	size_t n_leading_zeros = 0;
+	while (n_in && *in == 0)
+		++n_leading_zeros, ++in, --n_in;
+	memset(out, '1', n_leading_zeros);
+	out += n_leading_zeros, n_out -= n_leading_zeros;
+
+	// use out as a temporary scratch space to append the hash fragment
+	memcpy(out, in, n_in);
+	if (checksum) {
+		memcpy(out + n_in, checksum, 4);
+		n_in += 4;
+	}
+
+	bytes_to_limbs(limbs, (uint8_t *) out, n_in);
+	return n_leading_zeros + encode_limbs(out, n_out, limbs, MP_NLIMBS(n_in), alloc);
+}
+
+
+// Decodes in[0..n_in) into out, which must have room for at least
+// base58check_decode_buffer_size(in, n_in, 0) bytes, using limbs, which must have
+// room for at least MP_NLIMBS of that many bytes. The input must already have
+// been validated by scan_digits, which counted its n_leading_zeros leading '1'
+// characters. The decoded size, including the n_check bytes of any hash
+// fragment, is returned through n_out. The checksum is not verified.
+static int decode_payload(unsigned char *restrict out, size_t *restrict n_out, const char *restrict in, size_t n_in, size_t n_leading_zeros, size_t n_check, mp_limb_t *restrict limbs, const struct base58check_allocator *alloc) {
+	in += n_leading_zeros, n_in -= n_leading_zeros;
+	memset(out, 0, n_leading_zeros);
+	out += n_leading_zeros;
+
+	size_t n = 0;
+	if (n_in) {
+		n = decoded_size_upper_bound(n_in);
+		mp_size_t n_limbs = decode_limbs(limbs, in, n_in, alloc);
+		memset(limbs + n_limbs, 0, (MP_NLIMBS(n) - n_limbs) * sizeof(mp_limb_t)); // decode_limbs might not write the most significant limbs
+		limbs_to_bytes(out, limbs, n);
+		if (!*out) {
+			size_t chomp = 0;
+			while (!out[++chomp]);
+			memmove(out, out + chomp, n -= chomp);
+		}
+	}
+	if ((n += n_leading_zeros) < n_check /* must have a hash fragment at least */)
+		return BASE58CHECK_ELENGTH;
+	*n_out = n;
+	return 0;
+}
+
+struct base58check_ctx {
+	mp_limb_t *limbs;
+	size_t n_limbs;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MD *md;
+#else
+	const EVP_MD *md;
+#endif
+	EVP_MD_CTX *md_ctx;
+	struct base58check_allocator alloc;
+};
+
+static bool ctx_reserve_limbs(struct base58check_ctx *ctx, size_t n_limbs) {
+	if (_likely(n_limbs <= ctx->n_limbs))
+		return true;
+	mp_limb_t *limbs = ctx->alloc.alloc(ctx->alloc.opaque, n_limbs * sizeof(mp_limb_t));
+	if (!limbs)
+		return false;
+	if (ctx->limbs)
+		ctx->alloc.free(ctx->alloc.opaque, ctx->limbs, ctx->n_limbs * sizeof(mp_limb_t));
+	ctx->limbs = limbs, ctx->n_limbs = n_limbs;
+	return true;
+}
+
+static void ctx_double_sha256(struct base58check_ctx *ctx, unsigned char hash[32], const unsigned char *in, size_t n_in) {
+	// a prefetched digest avoids the per-call algorithm lookup of SHA256()
+	if (ctx->md && ctx->md_ctx &&
+			EVP_DigestInit_ex(ctx->md_ctx, ctx->md, NULL) &&
+			EVP_DigestUpdate(ctx->md_ctx, in, n_in) &&
+			EVP_DigestFinal_ex(ctx->md_ctx, hash, NULL) &&
+			EVP_DigestInit_ex(ctx->md_ctx, ctx->md, NULL) &&
+			EVP_DigestUpdate(ctx->md_ctx, hash, 32) &&
+			EVP_DigestFinal_ex(ctx->md_ctx, hash, NULL))
+		return;
+	sha256d(hash, in, n_in);
+}
+
+static size_t encode_buffer_size(const unsigned char in[], size_t n_in, size_t n_check, size_t n_pad) {
 	size_t n_leading_zeros = 0;
 	while (n_in && *in == 0)
 		++n_leading_zeros, ++in, --n_in;
 	size_t n_out;
-	if (__builtin_uaddl_overflow(n_in, 4, &n_in) ||
+	if (__builtin_uaddl_overflow(n_in, n_check, &n_in) ||
 			__builtin_uaddl_overflow(encoded_size_upper_bound(n_in), n_leading_zeros, &n_out) ||
 			__builtin_uaddl_overflow(n_out, n_pad, &n_out))
 		return SIZE_MAX;
 	return n_out;
 }
 
+size_t base58check_encode_buffer_size(const unsigned char in[], size_t n_in, size_t n_pad) {
+	return encode_buffer_size(in, n_in, 4, n_pad);
+}
+
+size_t base58_encode_buffer_size(const unsigned char in[], size_t n_in, size_t n_pad) {
+	return encode_buffer_size(in, n_in, 0, n_pad);
+}
+
 size_t base58check_decode_buffer_size(const char in[], size_t n_in, size_t n_pad) {
 	size_t n_leading_zeros = 0;
 	while (n_in && *in == '1')
@@ -258,111 +854,1723 @@ size_t base58check_decode_buffer_size(const char in[], size_t n_in, size_t n_pad
 	return n_out;
 }
 
-int base58check_encode(char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr) {
+void base58check_checksum(unsigned char *restrict out, const unsigned char *restrict in, size_t n_in) {
+	unsigned char hash[32];
+	sha256d(hash, in, n_in);
+	memcpy(out, hash, 4);
+}
+
+size_t base58check_encode_batch_buffer_size(const struct base58check_item in[], size_t n_items, size_t n_pad) {
+	size_t n_out = n_pad;
+	for (size_t i = 0; i < n_items; ++i)
+		if (__builtin_uaddl_overflow(n_out, base58check_encode_buffer_size(in[i].data, in[i].size, 0), &n_out))
+			return SIZE_MAX;
+	return n_out;
+}
+
+size_t base58check_decode_batch_buffer_size(const struct base58check_item in[], size_t n_items, size_t n_pad) {
+	size_t n_out = n_pad;
+	for (size_t i = 0; i < n_items; ++i)
+		if (__builtin_uaddl_overflow(n_out, base58check_decode_buffer_size(in[i].data, in[i].size, 0), &n_out))
+			return SIZE_MAX;
+	return n_out;
+}
+
+struct base58check_ctx * base58check_ctx_new_with_allocator(const struct base58check_allocator *allocator) {
+	// OpenSSL's digest objects would not come from the allocator, so such a
+	// context leaves them out and hashes with sha256d()
+	struct base58check_ctx *ctx = allocator->alloc(allocator->opaque, sizeof *ctx);
+	if (ctx)
+		*ctx = (struct base58check_ctx) { .alloc = *allocator };
+	return ctx;
+}
+
+struct base58check_ctx * base58check_ctx_new(void) {
+	struct base58check_ctx *ctx = base58check_ctx_new_with_allocator(&default_allocator);
+	if (ctx) {
+		// without these, hashing falls back to sha256d()
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		ctx->md = EVP_MD_fetch(NULL, "SHA256", NULL);
+#else
+		ctx->md = EVP_sha256();
+#endif
+		ctx->md_ctx = EVP_MD_CTX_new();
+	}
+	return ctx;
+}
+
+void base58check_ctx_free(struct base58check_ctx *ctx) {
+	struct base58check_allocator alloc = ctx->alloc;
+	if (ctx->limbs)
+		alloc.free(alloc.opaque, ctx->limbs, ctx->n_limbs * sizeof(mp_limb_t));
+	EVP_MD_CTX_free(ctx->md_ctx);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MD_free(ctx->md);
+#endif
+	alloc.free(alloc.opaque, ctx, sizeof *ctx);
+}
+
+static int encode_ex(struct base58check_ctx *restrict ctx, char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr, unsigned flags) {
+	if (!ctx) {
+		// small payloads need no more limbs than fit on the stack, so the
+		// temporary context never has to grow
+		mp_limb_t limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)];
+		struct base58check_ctx tmp = { .alloc = default_allocator };
+		if (n_in <= STACK_PAYLOAD_SIZE - 4)
+			tmp.limbs = limbs, tmp.n_limbs = MP_NLIMBS(STACK_PAYLOAD_SIZE);
+		int ret = encode_ex(&tmp, out, n_out, in, n_in, n_hdr, flags);
+		if (tmp.limbs && tmp.limbs != limbs)
+			base58check_free(tmp.limbs);
+		return ret;
+	}
+
+	size_t n_check = flags & BASE58CHECK_RAW ? 0 : 4;
 	unsigned char hash[32];
-	SHA256(in, n_in, hash);
-	SHA256(hash, sizeof hash, hash);
+	if (n_check)
+		ctx_double_sha256(ctx, hash, in, n_in);
 
 	size_t n_leading_zeros = 0;
 	while (n_in && *in == 0)
 		++n_leading_zeros, ++in, --n_in;
 
-	// add 4 bytes for the hash fragment
-	if (__builtin_uaddl_overflow(n_in, 4, &n_in))
-		return -1;
+	// add the bytes of any hash fragment
+	size_t n_need;
+	if (__builtin_uaddl_overflow(n_in, n_check, &n_need))
+		return BASE58CHECK_ESIZE;
 
-	size_t n_need = encoded_size_upper_bound(n_in);
+	n_need = encoded_size_upper_bound(n_need);
 	if (__builtin_uaddl_overflow(n_need, n_hdr, &n_need) ||
 			__builtin_uaddl_overflow(n_need, n_leading_zeros, &n_need))
-		return -1;
+		return BASE58CHECK_ESIZE;
 
 	char *out_ = *out;
 	size_t n_out_ = *n_out;
 	if (!out_) {
-		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_) ||
-				!(out_ = base58check_malloc(n_out_)))
-			return -1;
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = ctx->alloc.alloc(ctx->alloc.opaque, n_out_ ?: 1)))
+			return BASE58CHECK_ENOMEM;
 	}
 	else if (n_out_ < n_need)
-		return -1;
+		return BASE58CHECK_ESIZE;
 
-	memset(out_ + n_hdr, '1', n_leading_zeros);
-	out_ += n_hdr += n_leading_zeros, n_out_ -= n_hdr;
+	if (ctx_reserve_limbs(ctx, MP_NLIMBS(n_in + n_check))) {
+		n_out_ = encode_payload(out_ + n_hdr, n_out_ - n_hdr, in - n_leading_zeros, n_in + n_leading_zeros, n_check ? hash : NULL, ctx->limbs, &ctx->alloc);
 
-	// use out_ as a temporary scratch space to append the hash fragment
-	memcpy(out_, in, n_in - 4);
-	memcpy(out_ + (n_in - 4), hash, 4);
-
-	size_t n_limbs = MP_NLIMBS(n_in);
-	mp_limb_t *limbs = base58check_malloc(n_limbs * sizeof(mp_limb_t));
-	if (limbs) {
-		bytes_to_limbs(limbs, (uint8_t *) out_, n_in);
-		n_out_ = encode_limbs(out_, n_out_, limbs, n_limbs);
-		base58check_free(limbs);
-
-		*out = out_ - n_hdr;
+		*out = out_;
 		*n_out = n_out_ + n_hdr;
 		return 0;
 	}
 	if (!*out)
-		base58check_free(out_ - n_hdr);
-	return -1;
+		ctx->alloc.free(ctx->alloc.opaque, out_, n_out_ ?: 1);
+	return BASE58CHECK_ENOMEM;
 }
 
-int base58check_decode(unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr) {
-	size_t n_leading_zeros = 0;
-	while (n_in && *in == '1')
-		++n_leading_zeros, ++in, --n_in;
+static int decode_ex(struct base58check_ctx *restrict ctx, unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr, unsigned flags) {
+	if (!ctx) {
+		// small payloads need no more limbs than fit on the stack, so the
+		// temporary context never has to grow
+		mp_limb_t limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)];
+		struct base58check_ctx tmp = { .alloc = default_allocator };
+		if (n_in <= STACK_PAYLOAD_SIZE - 4)
+			tmp.limbs = limbs, tmp.n_limbs = MP_NLIMBS(STACK_PAYLOAD_SIZE);
+		int ret = decode_ex(&tmp, out, n_out, in, n_in, n_hdr, flags);
+		if (tmp.limbs && tmp.limbs != limbs)
+			base58check_free(tmp.limbs);
+		return ret;
+	}
 
-	size_t n_need = decoded_size_upper_bound(n_in) + n_leading_zeros;
-	if (n_need < 4 /* must have a hash fragment at least */ ||
-			__builtin_uaddl_overflow(n_need, n_hdr, &n_need))
-		return -1;
+	size_t n_check = flags & BASE58CHECK_RAW ? 0 : 4;
+	size_t n_need = base58check_decode_buffer_size(in, n_in, 0);
+	if (n_need < n_check /* must have a hash fragment at least */)
+		return BASE58CHECK_ELENGTH;
+	size_t n_limbs = MP_NLIMBS(n_need);
+	if (n_need == SIZE_MAX || __builtin_uaddl_overflow(n_need, n_hdr, &n_need))
+		return BASE58CHECK_ESIZE;
+	// reject bad characters before committing any memory to them
+	size_t n_leading_zeros = scan_digits(NULL, in, n_in);
+	if (n_leading_zeros == SIZE_MAX)
+		return BASE58CHECK_ECHAR;
 
 	unsigned char *out_ = *out;
 	size_t n_out_ = *n_out;
 	if (!out_) {
-		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_) ||
-				!(out_ = base58check_malloc(n_out_)))
-			return -1;
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = ctx->alloc.alloc(ctx->alloc.opaque, n_out_ ?: 1)))
+			return BASE58CHECK_ENOMEM;
 	}
 	else if (n_out_ < n_need)
-		return -1;
-	else
-		n_out_ = n_need;
-
-	memset(out_ + n_hdr, 0, n_leading_zeros);
-	out_ += n_hdr += n_leading_zeros, n_out_ -= n_hdr;
-
-	size_t n_limbs = MP_NLIMBS(n_out_);
-	mp_limb_t *limbs;
-	if (n_limbs && (limbs = base58check_malloc(n_limbs * sizeof(mp_limb_t)))) {
-		limbs[n_limbs - 1] = 0; // decode_limbs might not write the most significant limb
-		if (decode_limbs(limbs, in, n_in) >= 0) {
-			limbs_to_bytes(out_, limbs, n_out_);
-			base58check_free(limbs);
-			if (!*out_) {
-				size_t chomp = 0;
-				while (!out_[++chomp]);
-				memmove(out_, out_ + chomp, n_out_ -= chomp);
-			}
-			out_ -= n_leading_zeros, n_out_ += n_leading_zeros, n_hdr -= n_leading_zeros;
+		return BASE58CHECK_ESIZE;
+	size_t n_alloc = n_out_ ?: 1;
 
+	int ret = BASE58CHECK_ENOMEM;
+	if (ctx_reserve_limbs(ctx, n_limbs) &&
+			(ret = decode_payload(out_ + n_hdr, &n_out_, in, n_in, n_leading_zeros, n_check, ctx->limbs, &ctx->alloc)) == 0) {
+		n_out_ -= n_check;
+		bool verified = flags & (BASE58CHECK_RAW | BASE58CHECK_TRUSTED);
+		if (!verified) {
 			unsigned char hash[32];
-			SHA256(out_, n_out_ -= 4, hash);
-			SHA256(hash, sizeof hash, hash);
-			if (!memcmp(hash, out_ + n_out_, 4)) {
-				*out = out_ - n_hdr;
-				*n_out = n_out_ + n_hdr;
-				return 0;
-			}
+			ctx_double_sha256(ctx, hash, out_ + n_hdr, n_out_);
+			verified = !memcmp(hash, out_ + n_hdr + n_out_, 4);
 		}
-		else
-			base58check_free(limbs);
+		if (verified) {
+			*out = out_;
+			*n_out = n_out_ + n_hdr;
+			return 0;
+		}
+		ret = BASE58CHECK_ECHECKSUM;
 	}
 	if (!*out)
-		base58check_free(out_ - n_hdr);
-	return -1;
+		ctx->alloc.free(ctx->alloc.opaque, out_, n_alloc);
+	return ret;
+}
+
+static int decode_inplace(char *buf, size_t n, size_t *n_out) {
+	size_t n_need = base58check_decode_buffer_size(buf, n, 0);
+	if (n_need < 4 /* must have a checksum at least */)
+		return BASE58CHECK_ELENGTH;
+	if (n_need == SIZE_MAX)
+		return BASE58CHECK_ESIZE;
+	size_t n_leading_zeros = scan_digits(NULL, buf, n);
+	if (n_leading_zeros == SIZE_MAX)
+		return BASE58CHECK_ECHAR;
+	const char *in = buf + n_leading_zeros;
+	size_t n_in = n - n_leading_zeros;
+
+	// The number is built up in the characters already consumed, starting at
+	// the first aligned limb of the buffer. It takes about 0.73 bytes per
+	// character, so once a block's worth of characters has been consumed, the
+	// limbs never catch up with the characters still to be read. The first
+	// block is decoded on the stack, as are inputs too short to have slack.
+	mp_limb_t first[DECODE_BLOCK / LIMB_DIGITS + 2], *limbs = first;
+	mp_size_t n_limbs = 0;
+	if (n_in) {
+		mp_limb_t *in_buf = (mp_limb_t *) (buf + (-(uintptr_t) buf & (sizeof(mp_limb_t) - 1)));
+		if (n_in < DECODE_BLOCK + LIMB_DIGITS)
+			n_limbs = decode_limbs_basecase(limbs, in, n_in);
+#ifndef NO_GMP
+		else if (n_in >= DC_DECODE_THRESHOLD) {
+			// only the product of the two halves lands in the buffer, once
+			// all of the input has been read
+			int k_max = dc_prepare(n_in);
+			size_t n_scratch = (4 * DC_LIMBS_FOR_DIGITS(n_in) + 8 * GMP_LIMB_BITS) * sizeof(mp_limb_t);
+			mp_limb_t *scratch;
+			if (k_max < 0 || !(scratch = base58check_malloc(n_scratch)))
+				return BASE58CHECK_ENOMEM;
+			n_limbs = dc_decode_limbs(limbs = in_buf, in, n_in, scratch, k_max);
+			base58check_free(scratch);
+		}
+#endif
+		if (!n_limbs) {
+			size_t n_first = DECODE_BLOCK + (n_in - DECODE_BLOCK) % LIMB_DIGITS;
+			n_limbs = decode_limbs_basecase(first, in, n_first);
+			memcpy(limbs = in_buf, first, n_limbs * sizeof(mp_limb_t));
+			n_limbs = decode_limbs_more(limbs, n_limbs, in + n_first, n_in - n_first);
+		}
+	}
+
+	// the leading '1' characters are the last to be overwritten
+	unsigned char *out = (unsigned char *) buf + n_leading_zeros, *bytes = (unsigned char *) limbs;
+	size_t n_bytes = n_limbs * sizeof(mp_limb_t);
+	limbs_to_bytes_inplace(limbs, n_limbs);
+	while (n_bytes && !*bytes)
+		++bytes, --n_bytes;
+	memmove(out, bytes, n_bytes);
+	memset(buf, 0, n_leading_zeros);
+	if ((n_bytes += n_leading_zeros) < 4)
+		return BASE58CHECK_ELENGTH;
+
+	unsigned char hash[32];
+	sha256d(hash, (unsigned char *) buf, n_bytes -= 4);
+	if (memcmp(hash, buf + n_bytes, 4))
+		return BASE58CHECK_ECHECKSUM;
+	*n_out = n_bytes;
+	return 0;
+}
+
+#ifdef ENABLE_STATS
+
+// Each thread counts its own calls in a block of its own, which is linked into
+// a list for snapshots to sum. Only the owning thread writes a block, so its
+// counters are bumped with relaxed loads and stores rather than atomic
+// read-modify-writes. When a thread exits, its counts are folded into the
+// retired totals and its block is freed.
+struct thread_stats {
+	struct base58check_stats stats;
+	struct thread_stats *prev, *next;
+};
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct thread_stats *stats_threads;
+static struct base58check_stats stats_retired;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stats_key;
+static __thread struct thread_stats *thread_stats;
+
+// sums the counters of from into to, treating both as arrays of uint64_t
+static void stats_add(struct base58check_stats *restrict to, const struct base58check_stats *restrict from) {
+	uint64_t *t = (uint64_t *) to;
+	const uint64_t *f = (const uint64_t *) from;
+	for (size_t i = 0; i < sizeof *to / sizeof *t; ++i)
+		t[i] += __atomic_load_n(&f[i], __ATOMIC_RELAXED);
+}
+
+static void stats_thread_exit(void *arg) {
+	struct thread_stats *ts = arg;
+	pthread_mutex_lock(&stats_lock);
+	stats_add(&stats_retired, &ts->stats);
+	if (ts->next)
+		ts->next->prev = ts->prev;
+	*(ts->prev ? &ts->prev->next : &stats_threads) = ts->next;
+	pthread_mutex_unlock(&stats_lock);
+	thread_stats = NULL;
+	free(ts);
+}
+
+static void stats_init(void) {
+	// without the key, blocks are never retired, which costs only memory
+	pthread_key_create(&stats_key, stats_thread_exit);
+}
+
+static struct thread_stats * stats_thread(void) {
+	struct thread_stats *ts = thread_stats;
+	if (_likely(ts))
+		return ts;
+	pthread_once(&stats_once, stats_init);
+	if (!(ts = calloc(1, sizeof *ts)))
+		return NULL;
+	pthread_mutex_lock(&stats_lock);
+	if ((ts->next = stats_threads))
+		stats_threads->prev = ts;
+	stats_threads = ts;
+	pthread_mutex_unlock(&stats_lock);
+	pthread_setspecific(stats_key, ts);
+	return thread_stats = ts;
+}
+
+static inline void stats_bump(uint64_t *counter, uint64_t n) {
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t stats_clock(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void stats_record(bool decode, size_t n_in, size_t n_out, int ret, uint64_t ns) {
+	struct thread_stats *ts = stats_thread();
+	if (_unlikely(!ts))
+		return;
+	struct base58check_op_stats *op = decode ? &ts->stats.decode : &ts->stats.encode;
+	stats_bump(&op->calls, 1);
+	stats_bump(&op->bytes_in, n_in);
+	if (ret == 0)
+		stats_bump(&op->bytes_out, n_out);
+	else if (-ret < BASE58CHECK_STATS_ERRORS)
+		stats_bump(&op->failures[-ret], 1);
+	unsigned bucket = ns ? 64 - (unsigned) __builtin_clzll(ns) : 0;
+	stats_bump(&op->latency[bucket < BASE58CHECK_STATS_BUCKETS ? bucket : BASE58CHECK_STATS_BUCKETS - 1], 1);
+}
+
+#endif // defined(ENABLE_STATS)
+
+int base58check_encode_ex(struct base58check_ctx *restrict ctx, char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr, unsigned flags) {
+#ifdef ENABLE_STATS
+	DTRACE_PROBE3(base58check, encode__entry, in, n_in, flags);
+	uint64_t start = stats_clock();
+	int ret = encode_ex(ctx, out, n_out, in, n_in, n_hdr, flags);
+	uint64_t ns = stats_clock() - start;
+	size_t n = ret ? 0 : *n_out - n_hdr;
+	stats_record(false, n_in, n, ret, ns);
+	DTRACE_PROBE3(base58check, encode__return, ret, n, ns);
+	return ret;
+#else
+	return encode_ex(ctx, out, n_out, in, n_in, n_hdr, flags);
+#endif
+}
+
+int base58check_decode_ex(struct base58check_ctx *restrict ctx, unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr, unsigned flags) {
+#ifdef ENABLE_STATS
+	DTRACE_PROBE3(base58check, decode__entry, in, n_in, flags);
+	uint64_t start = stats_clock();
+	int ret = decode_ex(ctx, out, n_out, in, n_in, n_hdr, flags);
+	uint64_t ns = stats_clock() - start;
+	size_t n = ret ? 0 : *n_out - n_hdr;
+	stats_record(true, n_in, n, ret, ns);
+	DTRACE_PROBE3(base58check, decode__return, ret, n, ns);
+	return ret;
+#else
+	return decode_ex(ctx, out, n_out, in, n_in, n_hdr, flags);
+#endif
+}
+
+int base58check_decode_inplace(char *buf, size_t n, size_t *n_out) {
+#ifdef ENABLE_STATS
+	DTRACE_PROBE3(base58check, decode__entry, buf, n, 0);
+	uint64_t start = stats_clock();
+	int ret = decode_inplace(buf, n, n_out);
+	uint64_t ns = stats_clock() - start;
+	size_t n_decoded = ret ? 0 : *n_out;
+	stats_record(true, n, n_decoded, ret, ns);
+	DTRACE_PROBE3(base58check, decode__return, ret, n_decoded, ns);
+	return ret;
+#else
+	return decode_inplace(buf, n, n_out);
+#endif
+}
+
+int base58check_stats_snapshot(struct base58check_stats *stats) {
+	memset(stats, 0, sizeof *stats);
+#ifdef ENABLE_STATS
+	pthread_mutex_lock(&stats_lock);
+	stats_add(stats, &stats_retired);
+	for (const struct thread_stats *ts = stats_threads; ts; ts = ts->next)
+		stats_add(stats, &ts->stats);
+	pthread_mutex_unlock(&stats_lock);
+	return 0;
+#else
+	return BASE58CHECK_ENOTSUP;
+#endif
+}
+
+int base58check_encode_ctx(struct base58check_ctx *restrict ctx, char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_encode_ex(ctx, out, n_out, in, n_in, n_hdr, 0);
+}
+
+int base58check_decode_ctx(struct base58check_ctx *restrict ctx, unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_decode_ex(ctx, out, n_out, in, n_in, n_hdr, 0);
+}
+
+int base58check_encode(char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_encode_ex(NULL, out, n_out, in, n_in, n_hdr, 0);
+}
+
+int base58check_decode(unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_decode_ex(NULL, out, n_out, in, n_in, n_hdr, 0);
+}
+
+int base58_encode(char **restrict out, size_t *n_out, const unsigned char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_encode_ex(NULL, out, n_out, in, n_in, n_hdr, BASE58CHECK_RAW);
+}
+
+int base58_decode(unsigned char **restrict out, size_t *n_out, const char *restrict in, size_t n_in, size_t n_hdr) {
+	return base58check_decode_ex(NULL, out, n_out, in, n_in, n_hdr, BASE58CHECK_RAW);
+}
+
+int base58check_verify(const char *restrict in, size_t n_in, size_t *restrict n_decoded) {
+	size_t n_need = base58check_decode_buffer_size(in, n_in, 0);
+	if (n_need < 4 /* must have a hash fragment at least */)
+		return BASE58CHECK_ELENGTH;
+	if (n_need == SIZE_MAX)
+		return BASE58CHECK_ESIZE;
+	size_t n_leading_zeros = scan_digits(NULL, in, n_in);
+	if (n_leading_zeros == SIZE_MAX)
+		return BASE58CHECK_ECHAR;
+
+	unsigned char stack_bytes[STACK_PAYLOAD_SIZE];
+	mp_limb_t stack_limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)];
+	unsigned char *bytes = stack_bytes;
+	mp_limb_t *limbs = stack_limbs;
+	if (_unlikely(n_need > STACK_PAYLOAD_SIZE)) {
+		if (!(limbs = base58check_malloc(MP_NLIMBS(n_need) * sizeof(mp_limb_t) + n_need)))
+			return BASE58CHECK_ENOMEM;
+		bytes = (unsigned char *) (limbs + MP_NLIMBS(n_need));
+	}
+
+	// Unlike decode_payload(), the significant bytes are left where they land,
+	// and the leading zeros are written just ahead of them, so nothing moves.
+	in += n_leading_zeros, n_in -= n_leading_zeros;
+	size_t n = 0, chomp = n_leading_zeros;
+	if (n_in) {
+		n = decoded_size_upper_bound(n_in);
+		mp_size_t n_limbs = decode_limbs(limbs, in, n_in, &default_allocator);
+		memset(limbs + n_limbs, 0, (MP_NLIMBS(n) - n_limbs) * sizeof(mp_limb_t));
+		limbs_to_bytes(bytes + n_leading_zeros, limbs, n);
+		while (!bytes[chomp])
+			++chomp, --n;
+	}
+	chomp -= n_leading_zeros;
+	memset(bytes + chomp, 0, n_leading_zeros);
+	n += n_leading_zeros;
+
+	int ret = BASE58CHECK_ELENGTH;
+	if (n >= 4) {
+		unsigned char hash[32];
+		sha256d(hash, bytes + chomp, n -= 4);
+		if (!memcmp(hash, bytes + chomp + n, 4)) {
+			if (n_decoded)
+				*n_decoded = n;
+			ret = 0;
+		}
+		else
+			ret = BASE58CHECK_ECHECKSUM;
+	}
+	if (limbs != stack_limbs)
+		base58check_free(limbs);
+	return ret;
+}
+
+// Whether n_in characters, of which exactly the first n_ones are '1', can
+// encode a number of n bytes, the first n_ones of which are zero.
+static bool plausible_length(size_t n_in, size_t n_ones, size_t n) {
+	if (n_ones > n)
+		return false;
+	size_t n_sig = n - n_ones, n_digits = n_in - n_ones;
+	if (!n_sig)
+		return !n_digits;
+	// The significant bytes are at least 256**(n_sig - 1), which has more
+	// than (n_sig - 1) * log(256)/log(58) digits; 1365658/1000000
+	// approximates log(256)/log(58) from below.
+	if (n_sig - 1 <= SIZE_MAX / 1365658 && n_digits <= (n_sig - 1) * 1365658 / 1000000)
+		return false;
+	return n_digits <= encoded_size_upper_bound(n_sig);
+}
+
+int base58check_decode_expect(unsigned char *restrict out, size_t n_out, const char *restrict in, size_t n_in, const unsigned char *restrict version, size_t n_version) {
+	size_t n;
+	if (n_version > n_out || __builtin_uaddl_overflow(n_out, 4, &n))
+		return BASE58CHECK_ESIZE;
+
+	size_t n_ones = 0, n_version_zeros = 0;
+	while (n_ones < n_in && in[n_ones] == '1')
+		++n_ones;
+	if (!plausible_length(n_in, n_ones, n))
+		return BASE58CHECK_ELENGTH;
+	// Leading '1' characters stand for exactly the leading zero bytes, so
+	// they must match a version that has any nonzero byte and cover one that
+	// has none.
+	while (n_version_zeros < n_version && !version[n_version_zeros])
+		++n_version_zeros;
+	if (n_version_zeros < n_version ? n_ones != n_version_zeros : n_ones < n_version)
+		return BASE58CHECK_EVERSION;
+	if (scan_digits(NULL, in, n_in) == SIZE_MAX)
+		return BASE58CHECK_ECHAR;
+
+	size_t n_need = base58check_decode_buffer_size(in, n_in, 0);
+	unsigned char stack_bytes[STACK_PAYLOAD_SIZE];
+	mp_limb_t stack_limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)];
+	unsigned char *bytes = stack_bytes;
+	mp_limb_t *limbs = stack_limbs;
+	if (_unlikely(n_need > STACK_PAYLOAD_SIZE)) {
+		if (!(limbs = base58check_malloc(MP_NLIMBS(n_need) * sizeof(mp_limb_t) + n_need)))
+			return BASE58CHECK_ENOMEM;
+		bytes = (unsigned char *) (limbs + MP_NLIMBS(n_need));
+	}
+
+	size_t n_decoded;
+	int ret = decode_payload(bytes, &n_decoded, in, n_in, n_ones, 4, limbs, &default_allocator);
+	if (ret == 0 && n_decoded != n)
+		ret = BASE58CHECK_ELENGTH;
+	else if (ret == 0 && n_version && memcmp(bytes, version, n_version))
+		ret = BASE58CHECK_EVERSION;
+	else if (ret == 0) {
+		unsigned char hash[32];
+		sha256d(hash, bytes, n_out);
+		if (!memcmp(hash, bytes + n_out, 4))
+			memcpy(out, bytes, n_out);
+		else
+			ret = BASE58CHECK_ECHECKSUM;
+	}
+	if (limbs != stack_limbs)
+		base58check_free(limbs);
+	return ret;
+}
+
+// Divides the n_limbs limbs at limbs, which are destroyed, down into base-LIMB_BASE
+// digits, least significant first. Returns the number of digits, the last of
+// which is nonzero.
+static size_t limbs_to_big_digits(mp_limb_t *restrict big, mp_limb_t *restrict limbs, mp_size_t n_limbs) {
+	size_t n_big = 0;
+	for (;;) {
+		while (n_limbs && !limbs[n_limbs - 1])
+			--n_limbs;
+		if (!n_limbs)
+			return n_big;
+		big[n_big++] = limbs_divrem_base(limbs, n_limbs);
+	}
+}
+
+// Writes the base-58 digits of the number whose base-LIMB_BASE digits, least
+// significant first, are big[0..n_big). Returns the number of characters.
+static size_t big_digits_to_chars(char *restrict out, const mp_limb_t *restrict big, size_t n_big) {
+	if (!n_big)
+		return 0;
+	char *p = out, top[LIMB_DIGITS];
+	size_t n_top = 0;
+	for (mp_limb_t d = big[n_big - 1]; d; d /= 58)
+		top[n_top++] = encode[d % 58];
+	while (n_top)
+		*p++ = top[--n_top];
+	for (size_t i = n_big - 1; i--; p += LIMB_DIGITS)
+		limb_to_chars(p, big[i]);
+	return (size_t) (p - out);
+}
+
+struct base58check_prefix_encoder {
+	struct sha256_midstate midstate;
+	size_t n_prefix, n_tail;
+	// number of leading zero bytes in the prefix, which is n_prefix if the
+	// prefix is all zeros
+	size_t n_leading_zeros;
+	// whether prefix, tail, and checksum together fit on the stack, without
+	// which the prefix's contribution is not precomputed
+	bool small;
+	// the base-LIMB_BASE digits of prefix * 256**(n_tail + 4)
+	mp_limb_t *big;
+	size_t n_big;
+	unsigned char prefix[];
+};
+
+struct base58check_prefix_encoder * base58check_prefix_encoder_new(const unsigned char *prefix, size_t n_prefix, size_t n_tail) {
+	size_t n_total, n_enc;
+	if (__builtin_uaddl_overflow(n_prefix, n_tail, &n_total) ||
+			__builtin_uaddl_overflow(n_total, 4, &n_total) ||
+			__builtin_uaddl_overflow(sizeof(struct base58check_prefix_encoder), n_prefix, &n_enc))
+		return NULL;
+	struct base58check_prefix_encoder *enc = base58check_malloc(n_enc);
+	if (!enc)
+		return NULL;
+	*enc = (struct base58check_prefix_encoder) { .n_prefix = n_prefix, .n_tail = n_tail };
+	memcpy(enc->prefix, prefix, n_prefix);
+	sha256_midstate_init(&enc->midstate, enc->prefix, n_prefix);
+	while (enc->n_leading_zeros < n_prefix && !prefix[enc->n_leading_zeros])
+		++enc->n_leading_zeros;
+
+	enc->small = n_total <= STACK_PAYLOAD_SIZE;
+	if (enc->small && enc->n_leading_zeros < n_prefix) {
+		// the prefix's contribution is converted once here, by the same means
+		// as the tails will be, and then only ever added
+		unsigned char bytes[STACK_PAYLOAD_SIZE] = { };
+		mp_limb_t limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)], big[BIG_DIGITS_FOR_BYTES(STACK_PAYLOAD_SIZE)];
+		memcpy(bytes, prefix, n_prefix);
+		bytes_to_limbs(limbs, bytes, n_total);
+		enc->n_big = limbs_to_big_digits(big, limbs, MP_NLIMBS(n_total));
+		if (!(enc->big = base58check_malloc(enc->n_big * sizeof(mp_limb_t)))) {
+			base58check_free(enc);
+			return NULL;
+		}
+		memcpy(enc->big, big, enc->n_big * sizeof(mp_limb_t));
+	}
+	return enc;
+}
+
+void base58check_prefix_encoder_free(struct base58check_prefix_encoder *enc) {
+	if (enc->big)
+		base58check_free(enc->big);
+	base58check_free(enc);
+}
+
+size_t base58check_prefix_encode_buffer_size(const struct base58check_prefix_encoder *enc, const unsigned char tail[], size_t n_tail, size_t n_pad) {
+	if (enc->n_leading_zeros == enc->n_prefix) {
+		size_t n_out = base58check_encode_buffer_size(tail, n_tail, n_pad);
+		if (n_out == SIZE_MAX || __builtin_uaddl_overflow(n_out, enc->n_prefix, &n_out))
+			return SIZE_MAX;
+		return n_out;
+	}
+	size_t n_in, n_out;
+	if (__builtin_uaddl_overflow(enc->n_prefix - enc->n_leading_zeros, n_tail, &n_in) ||
+			__builtin_uaddl_overflow(n_in, 4, &n_in) ||
+			__builtin_uaddl_overflow(encoded_size_upper_bound(n_in), enc->n_leading_zeros, &n_out) ||
+			__builtin_uaddl_overflow(n_out, n_pad, &n_out))
+		return SIZE_MAX;
+	return n_out;
+}
+
+int base58check_prefix_encode(const struct base58check_prefix_encoder *restrict enc, char **restrict out, size_t *n_out, const unsigned char *restrict tail, size_t n_tail, size_t n_hdr) {
+	size_t n_need = base58check_prefix_encode_buffer_size(enc, tail, n_tail, 0);
+	if (n_need == SIZE_MAX || __builtin_uaddl_overflow(n_need, n_hdr, &n_need))
+		return BASE58CHECK_ESIZE;
+
+	char *out_ = *out;
+	size_t n_out_ = *n_out;
+	if (!out_) {
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = base58check_malloc(n_out_)))
+			return BASE58CHECK_ENOMEM;
+	}
+	else if (n_out_ < n_need)
+		return BASE58CHECK_ESIZE;
+
+	unsigned char hash[32];
+	sha256d_finish(hash, &enc->midstate, tail, n_tail);
+
+	if (_unlikely(n_tail != enc->n_tail || !enc->small)) {
+		// Tails of other sizes shift the prefix by other amounts, and large
+		// ones do not fit on the stack, so these are converted in full, on
+		// the stack if the whole payload fits there.
+		size_t n_in = enc->n_prefix + n_tail;
+		unsigned char stack_bytes[STACK_PAYLOAD_SIZE], *in = stack_bytes;
+		mp_limb_t stack_limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)], *limbs = stack_limbs;
+		if (_unlikely(n_in > STACK_PAYLOAD_SIZE - 4)) {
+			if (!(limbs = base58check_malloc(MP_NLIMBS(n_in + 4) * sizeof(mp_limb_t) + n_in))) {
+				if (!*out)
+					base58check_free(out_);
+				return BASE58CHECK_ENOMEM;
+			}
+			in = (unsigned char *) (limbs + MP_NLIMBS(n_in + 4));
+		}
+		memcpy(in, enc->prefix, enc->n_prefix);
+		memcpy(in + enc->n_prefix, tail, n_tail);
+		n_out_ = encode_payload(out_ + n_hdr, n_out_ - n_hdr, in, n_in, hash, limbs, &default_allocator);
+		if (limbs != stack_limbs)
+			base58check_free(limbs);
+		*out = out_;
+		*n_out = n_out_ + n_hdr;
+		return 0;
+	}
+
+	// The value of the payload is the precomputed contribution of the prefix
+	// plus the value of the tail and checksum, so only the latter is divided
+	// out, and the two are summed digit by digit.
+	unsigned char bytes[STACK_PAYLOAD_SIZE];
+	mp_limb_t limbs[MP_NLIMBS(STACK_PAYLOAD_SIZE)], big[BIG_DIGITS_FOR_BYTES(STACK_PAYLOAD_SIZE) + 1];
+	memcpy(bytes, tail, n_tail);
+	memcpy(bytes + n_tail, hash, 4);
+	bytes_to_limbs(limbs, bytes, n_tail + 4);
+	size_t n_big = limbs_to_big_digits(big, limbs, MP_NLIMBS(n_tail + 4));
+	if (enc->n_big) {
+		mp_limb_t carry = 0;
+		for (size_t i = 0; i < enc->n_big; ++i) {
+			mp_limb_t d = (i < n_big ? big[i] : 0) + enc->big[i] + carry;
+			carry = d >= LIMB_BASE;
+			big[i] = carry ? d - LIMB_BASE : d;
+		}
+		n_big = enc->n_big; // the prefix's contribution is the larger
+		if (carry)
+			big[n_big++] = carry;
+	}
+
+	size_t n_leading_zeros = enc->n_leading_zeros;
+	if (n_leading_zeros == enc->n_prefix)
+		for (size_t i = 0; i < n_tail + 4 && !bytes[i]; ++i)
+			++n_leading_zeros;
+	char *p = out_ + n_hdr;
+	memset(p, '1', n_leading_zeros);
+	n_out_ = n_leading_zeros + big_digits_to_chars(p + n_leading_zeros, big, n_big);
+	*out = out_;
+	*n_out = n_out_ + n_hdr;
+	return 0;
+}
+
+// The values that the significant bytes of a payload and its checksum, those
+// after the zero bytes that the prefix's leading '1' characters stand for, can
+// take for the encoding to begin with the prefix: one range for each length
+// of encoding that can begin with it. Ranges for successive lengths are a
+// factor of 58 apart, and numbers of a given size in bytes span a factor of
+// 256, so at most two lengths are possible.
+struct prefix_ranges {
+	size_t n_ones, n_bytes, n_ranges;
+	unsigned char *lo[2], *hi[2]; // inclusive bounds, big-endian, n_bytes each
+};
+
+// Multiplies the n-byte big-endian number x by mul and adds add. Returns the
+// carry out of the most significant byte.
+static unsigned bytes_mul_add(unsigned char x[], size_t n, unsigned mul, unsigned add) {
+	for (size_t i = n; i-- > 0;) {
+		add += x[i] * mul;
+		x[i] = (unsigned char) add;
+		add >>= 8;
+	}
+	return add;
+}
+
+// Subtracts 1 from the nonzero n-byte big-endian number x.
+static void bytes_decrement(unsigned char x[], size_t n) {
+	while (x[--n]-- == 0)
+		;
+}
+
+// Computes the ranges for prefix[0..n_prefix) and payloads of n_payload bytes
+// into r, whose bounds are allocated in one block at r->lo[0]. Returns
+// BASE58CHECK_ELENGTH if no encoding of such a payload can begin with the
+// prefix.
+static int prefix_ranges_init(struct prefix_ranges *r, const char *prefix, size_t n_prefix, size_t n_payload) {
+	*r = (struct prefix_ranges) { };
+	uint8_t *digits = base58check_malloc(n_prefix ?: 1);
+	if (!digits)
+		return BASE58CHECK_ENOMEM;
+	size_t n_ones = scan_digits(digits, prefix, n_prefix), m = 0;
+	int ret = 0;
+	if (n_ones == SIZE_MAX)
+		ret = BASE58CHECK_ECHAR;
+	// leading zero bytes are never taken from the checksum
+	else if (n_ones > n_payload)
+		ret = BASE58CHECK_ELENGTH;
+	else if (n_ones < n_prefix) {
+		m = n_payload + 4 - n_ones;
+		// the bounds are followed by a and b, the prefix's value and its
+		// successor, scaled up by 58 for each digit that follows the prefix
+		unsigned char *buf = base58check_malloc(m * 6);
+		if (!buf)
+			ret = BASE58CHECK_ENOMEM;
+		else {
+			unsigned char *a = buf + m * 4, *b = a + m;
+			unsigned a_over = 0, b_over;
+			memset(a, 0, m);
+			for (size_t i = n_ones; i < n_prefix; ++i)
+				a_over |= bytes_mul_add(a, m, 58, digits[i]);
+			memcpy(b, a, m);
+			b_over = bytes_mul_add(b, m, 1, 1);
+			while (!a_over) {
+				unsigned char *lo = buf + r->n_ranges * m * 2, *hi = lo + m;
+				memcpy(lo, a, m);
+				if (!lo[0])
+					memset(lo, 0, m), lo[0] = 1;
+				if (b_over)
+					memset(hi, 0xFF, m);
+				else
+					memcpy(hi, b, m), bytes_decrement(hi, m);
+				if (memcmp(lo, hi, m) <= 0) {
+					assert(r->n_ranges < 2);
+					r->lo[r->n_ranges] = lo, r->hi[r->n_ranges] = hi, ++r->n_ranges;
+				}
+				if (b_over)
+					break;
+				a_over = bytes_mul_add(a, m, 58, 0);
+				b_over = bytes_mul_add(b, m, 58, 0);
+			}
+			if (!r->n_ranges)
+				base58check_free(buf), ret = BASE58CHECK_ELENGTH;
+			else
+				r->lo[0] = buf;
+		}
+	}
+	r->n_ones = n_ones, r->n_bytes = m;
+	base58check_free(digits);
+	return ret;
+}
+
+static void prefix_ranges_free(struct prefix_ranges *r) {
+	if (r->n_ranges)
+		base58check_free(r->lo[0]);
+}
+
+// Decides whether the encoding of payload[0..n) begins with the prefix. Only
+// if the payload falls on the edge of a range is its checksum computed.
+static inline bool prefix_match(const struct prefix_ranges *r, const unsigned char *payload, size_t n, uint64_t *n_checksums) {
+	for (size_t i = 0; i < r->n_ones; ++i)
+		if (payload[i])
+			return false;
+	if (!r->n_ranges)
+		return true;
+	const unsigned char *sig = payload + r->n_ones;
+	size_t n_sig = n - r->n_ones;
+	unsigned char hash[32];
+	bool hashed = false;
+	for (size_t k = 0; k < r->n_ranges; ++k) {
+		int c_lo = memcmp(sig, r->lo[k], n_sig), c_hi = memcmp(sig, r->hi[k], n_sig);
+		if (_likely(c_lo < 0 || c_hi > 0))
+			continue;
+		if (c_lo > 0 && c_hi < 0)
+			return true;
+		if (!hashed)
+			sha256d(hash, payload, n), hashed = true, ++*n_checksums;
+		if ((c_lo > 0 || memcmp(hash, r->lo[k] + n_sig, 4) >= 0) &&
+				(c_hi < 0 || memcmp(hash, r->hi[k] + n_sig, 4) <= 0))
+			return true;
+	}
+	return false;
+}
+
+// Whether any payload that begins with head[0..n_head) can match, whatever
+// its remaining bytes.
+static bool prefix_reachable(const struct prefix_ranges *r, const unsigned char *head, size_t n_head) {
+	for (size_t i = 0; i < r->n_ones && i < n_head; ++i)
+		if (head[i])
+			return false;
+	if (!r->n_ranges || n_head <= r->n_ones)
+		return true;
+	const unsigned char *fixed = head + r->n_ones;
+	size_t n_fixed = n_head - r->n_ones;
+	for (size_t k = 0; k < r->n_ranges; ++k)
+		if (memcmp(fixed, r->lo[k], n_fixed) >= 0 && memcmp(fixed, r->hi[k], n_fixed) <= 0)
+			return true;
+	return false;
+}
+
+static inline uint64_t splitmix64(uint64_t x) {
+	x += UINT64_C(0x9e3779b97f4a7c15);
+	x = (x ^ x >> 30) * UINT64_C(0xbf58476d1ce4e5b9);
+	x = (x ^ x >> 27) * UINT64_C(0x94d049bb133111eb);
+	return x ^ x >> 31;
+}
+
+struct search_state {
+	const struct base58check_search *search;
+	struct prefix_ranges ranges;
+	uint64_t next; // the first candidate of the next block to be claimed
+	bool stop;
+	int error;
+	pthread_mutex_t lock; // serializes calls of the match function
+	uint64_t candidates, checksums, matches;
+};
+
+static void search_report(struct search_state *st, const unsigned char *payload) {
+	const struct base58check_search *s = st->search;
+	char *enc = NULL;
+	size_t n_enc = 0;
+	int ret = encode_ex(NULL, &enc, &n_enc, payload, s->n_payload, 0, 0);
+	pthread_mutex_lock(&st->lock);
+	if (ret < 0)
+		st->error = ret, __atomic_store_n(&st->stop, true, __ATOMIC_RELAXED);
+	else if (!st->stop) {
+		++st->matches;
+		if (s->match(s->opaque, payload, s->n_payload, enc, n_enc) || st->matches == s->max_matches)
+			__atomic_store_n(&st->stop, true, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&st->lock);
+	if (ret == 0)
+		base58check_free(enc);
+}
+
+static void * search_main(void *arg) {
+	struct search_state *st = arg;
+	const struct base58check_search *s = st->search;
+	size_t n = s->n_payload;
+	unsigned char *payload = base58check_malloc(n ?: 1);
+	if (!payload) {
+		pthread_mutex_lock(&st->lock);
+		st->error = BASE58CHECK_ENOMEM, __atomic_store_n(&st->stop, true, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&st->lock);
+		return NULL;
+	}
+	if (!s->candidate)
+		memcpy(payload, s->head, s->n_head);
+
+	uint64_t candidates = 0, checksums = 0;
+	while (!__atomic_load_n(&st->stop, __ATOMIC_RELAXED)) {
+		uint64_t first = __atomic_fetch_add(&st->next, SEARCH_BLOCK, __ATOMIC_RELAXED), last = first + SEARCH_BLOCK;
+		if (s->max_candidates) {
+			if (first >= s->max_candidates)
+				break;
+			if (last > s->max_candidates)
+				last = s->max_candidates;
+		}
+		for (uint64_t i = first; i < last; ++i) {
+			if (s->candidate)
+				s->candidate(s->opaque, i, payload, n);
+			else {
+				// the built-in generator fills the bytes after the head
+				// with a splitmix64 stream keyed by the seed and index
+				uint64_t x = s->seed ^ splitmix64(i);
+				for (size_t j = s->n_head; j < n; j += 8) {
+					x = splitmix64(x);
+					memcpy(payload + j, &x, n - j < 8 ? n - j : 8);
+				}
+			}
+			if (_unlikely(prefix_match(&st->ranges, payload, n, &checksums)))
+				search_report(st, payload);
+		}
+		candidates += last - first;
+	}
+	__atomic_add_fetch(&st->candidates, candidates, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&st->checksums, checksums, __ATOMIC_RELAXED);
+	base58check_free(payload);
+	return NULL;
+}
+
+int base58check_search_prefix(const struct base58check_search *search, struct base58check_search_stats *stats) {
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (!search->candidate && search->n_head > search->n_payload)
+		return BASE58CHECK_ESIZE;
+	struct search_state st = { .search = search, .lock = PTHREAD_MUTEX_INITIALIZER };
+	int ret = prefix_ranges_init(&st.ranges, search->prefix, search->n_prefix, search->n_payload);
+	if (ret < 0)
+		return ret;
+	if (!search->candidate && !prefix_reachable(&st.ranges, search->head, search->n_head)) {
+		prefix_ranges_free(&st.ranges);
+		return BASE58CHECK_ELENGTH;
+	}
+
+	// the calling thread searches too, alongside as many others as can be
+	// started
+	long n_threads = search->n_threads ?: sysconf(_SC_NPROCESSORS_ONLN);
+	pthread_t *threads = n_threads > 1 ? base58check_malloc((size_t) (n_threads - 1) * sizeof *threads) : NULL;
+	size_t n_started = 0;
+	if (threads)
+		while (n_started < (size_t) (n_threads - 1) && !pthread_create(&threads[n_started], NULL, search_main, &st))
+			++n_started;
+	search_main(&st);
+	for (size_t i = 0; i < n_started; ++i)
+		pthread_join(threads[i], NULL);
+	if (threads)
+		base58check_free(threads);
+	prefix_ranges_free(&st.ranges);
+	pthread_mutex_destroy(&st.lock);
+
+	if (stats) {
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		*stats = (struct base58check_search_stats) {
+			.candidates = st.candidates, .checksums = st.checksums, .matches = st.matches,
+			.seconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9,
+		};
+	}
+	return st.error;
+}
+
+int base58check_encode_batch(char **restrict out, size_t *restrict n_out, size_t *restrict offsets, const struct base58check_item in[], size_t n_items) {
+	size_t n_need = 0, n_limbs = 0;
+	for (size_t i = 0; i < n_items; ++i) {
+		size_t n_item = base58check_encode_buffer_size(in[i].data, in[i].size, 0);
+		if (n_item == SIZE_MAX || __builtin_uaddl_overflow(n_need, n_item, &n_need))
+			return BASE58CHECK_ESIZE;
+		if (n_limbs < MP_NLIMBS(in[i].size + 4))
+			n_limbs = MP_NLIMBS(in[i].size + 4);
+	}
+
+	char *out_ = *out;
+	size_t n_out_ = *n_out;
+	if (!out_) {
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = base58check_malloc(n_out_ ?: 1)))
+			return BASE58CHECK_ENOMEM;
+	}
+	else if (n_out_ < n_need)
+		return BASE58CHECK_ESIZE;
+
+	mp_limb_t *limbs = NULL;
+	if (n_limbs && !(limbs = base58check_malloc(n_limbs * sizeof(mp_limb_t)))) {
+		if (!*out)
+			base58check_free(out_);
+		return BASE58CHECK_ENOMEM;
+	}
+
+	// Checksums for a group of items are computed together ahead of the group's
+	// base conversions so that the hashing and the bignum work do not serialize
+	// on each other item by item.
+	size_t pos = 0;
+	for (size_t i = 0; i < n_items; i += BATCH_GROUP) {
+		size_t n_group = n_items - i < BATCH_GROUP ? n_items - i : BATCH_GROUP;
+		const unsigned char *msgs[BATCH_GROUP];
+		size_t n_msgs[BATCH_GROUP];
+		unsigned char hashes[BATCH_GROUP][32];
+		for (size_t j = 0; j < n_group; ++j)
+			msgs[j] = in[i + j].data, n_msgs[j] = in[i + j].size;
+		sha256d_many(hashes, msgs, n_msgs, n_group);
+		for (size_t j = 0; j < n_group; ++j) {
+			const struct base58check_item *item = &in[i + j];
+			offsets[i + j] = pos;
+			pos += encode_payload(out_ + pos, base58check_encode_buffer_size(item->data, item->size, 0), item->data, item->size, hashes[j], limbs, &default_allocator);
+		}
+	}
+	offsets[n_items] = pos;
+
+	if (limbs)
+		base58check_free(limbs);
+	*out = out_;
+	*n_out = pos;
+	return 0;
+}
+
+int base58check_decode_batch(unsigned char **restrict out, size_t *restrict n_out, size_t *restrict offsets, int *restrict results, const struct base58check_item in[], size_t n_items) {
+	size_t n_need = 0, n_limbs = 0;
+	for (size_t i = 0; i < n_items; ++i) {
+		size_t n_item = base58check_decode_buffer_size(in[i].data, in[i].size, 0);
+		if (n_item == SIZE_MAX || __builtin_uaddl_overflow(n_need, n_item, &n_need))
+			return BASE58CHECK_ESIZE;
+		if (n_limbs < MP_NLIMBS(n_item))
+			n_limbs = MP_NLIMBS(n_item);
+	}
+
+	unsigned char *out_ = *out;
+	size_t n_out_ = *n_out;
+	if (!out_) {
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = base58check_malloc(n_out_ ?: 1)))
+			return BASE58CHECK_ENOMEM;
+	}
+	else if (n_out_ < n_need)
+		return BASE58CHECK_ESIZE;
+
+	mp_limb_t *limbs = NULL;
+	if (n_limbs && !(limbs = base58check_malloc(n_limbs * sizeof(mp_limb_t)))) {
+		if (!*out)
+			base58check_free(out_);
+		return BASE58CHECK_ENOMEM;
+	}
+
+	// A group of items is base-converted into the output buffer back to back,
+	// then the group's checksums are verified together, and then the verified
+	// payloads are compacted down over their hash fragments and any failures.
+	size_t pos = 0;
+	for (size_t i = 0; i < n_items; i += BATCH_GROUP) {
+		size_t n_group = n_items - i < BATCH_GROUP ? n_items - i : BATCH_GROUP;
+		size_t starts[BATCH_GROUP], sizes[BATCH_GROUP];
+		for (size_t j = 0, end = pos; j < n_group; ++j) {
+			const struct base58check_item *item = &in[i + j];
+			size_t n_leading_zeros = scan_digits(NULL, item->data, item->size);
+			if (n_leading_zeros == SIZE_MAX)
+				results[i + j] = BASE58CHECK_ECHAR;
+			else if ((results[i + j] = decode_payload(out_ + end, &sizes[j], item->data, item->size, n_leading_zeros, 4, limbs, &default_allocator)) == 0)
+				starts[j] = end, end += sizes[j];
+		}
+		const unsigned char *msgs[BATCH_GROUP];
+		size_t n_msgs[BATCH_GROUP], n_hashed = 0;
+		unsigned char hashes[BATCH_GROUP][32];
+		for (size_t j = 0; j < n_group; ++j)
+			if (results[i + j] == 0)
+				msgs[n_hashed] = out_ + starts[j], n_msgs[n_hashed++] = sizes[j] - 4;
+		sha256d_many(hashes, msgs, n_msgs, n_hashed);
+		for (size_t j = 0, k = 0; j < n_group; ++j)
+			if (results[i + j] == 0 && memcmp(hashes[k++], out_ + starts[j] + (sizes[j] - 4), 4))
+				results[i + j] = BASE58CHECK_ECHECKSUM;
+		for (size_t j = 0; j < n_group; ++j) {
+			offsets[i + j] = pos;
+			if (results[i + j] == 0) {
+				memmove(out_ + pos, out_ + starts[j], sizes[j] - 4);
+				pos += sizes[j] - 4;
+			}
+		}
+	}
+	offsets[n_items] = pos;
+
+	if (limbs)
+		base58check_free(limbs);
+	*out = out_;
+	*n_out = pos;
+	return 0;
+}
+
+static inline uint64_t load_le64(const unsigned char *p) {
+	uint64_t x;
+	memcpy(&x, p, sizeof x);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	return x;
+}
+
+static inline void store_le64(unsigned char *p, uint64_t x) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap64(x);
+#endif
+	memcpy(p, &x, sizeof x);
+}
+
+static inline uint32_t load_le32(const unsigned char *p) {
+	uint32_t x;
+	memcpy(&x, p, sizeof x);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap32(x);
+#endif
+	return x;
+}
+
+static inline void store_le32(unsigned char *p, uint32_t x) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	x = __builtin_bswap32(x);
+#endif
+	memcpy(p, &x, sizeof x);
+}
+
+// Hashes a payload a little-endian word at a time, so that a set's hashes are
+// the same on every machine that maps it. The low bits pick the home slot and
+// the high 32 bits are the tag, which is never 0, as that marks an empty slot.
+static uint64_t set_hash(const unsigned char *payload, size_t n, uint64_t seed) {
+	uint64_t h = seed;
+	for (; n >= 8; payload += 8, n -= 8)
+		h = splitmix64(h ^ load_le64(payload));
+	uint64_t tail = (uint64_t) n << 56;
+	for (size_t i = 0; i < n; ++i)
+		tail |= (uint64_t) payload[i] << i * 8;
+	return splitmix64(h ^ tail);
+}
+
+static inline uint32_t set_tag(uint64_t h) {
+	return (uint32_t) (h >> 32) ?: 1;
+}
+
+// Returns the slot holding payload, or else the empty slot at which its probe
+// ended, or SIZE_MAX if there was none, which only a corrupt image can cause.
+static size_t set_probe(const struct base58check_set *set, const unsigned char *payload, bool *found) {
+	const unsigned char *tags = set->image + SET_HEADER_SIZE, *payloads = tags + set->n_slots * 4;
+	uint64_t h = set_hash(payload, set->n_payload, set->seed);
+	uint32_t tag = set_tag(h);
+	size_t mask = set->n_slots - 1, slot = (size_t) h & mask;
+	for (size_t n = set->n_slots; n; --n, slot = slot + 1 & mask) {
+		uint32_t t = load_le32(tags + slot * 4);
+		if (!t)
+			break;
+		if (t == tag && !memcmp(payloads + slot * set->n_payload, payload, set->n_payload)) {
+			*found = true;
+			return slot;
+		}
+	}
+	*found = false;
+	return !load_le32(tags + slot * 4) ? slot : SIZE_MAX;
+}
+
+// Adds payload to a set being built, whose writable image is at image.
+static void set_insert(struct base58check_set *set, unsigned char *image, const unsigned char *payload) {
+	bool found;
+	size_t slot = set_probe(set, payload, &found);
+	if (found)
+		return;
+	// the table is sized for every item, so there is always an empty slot
+	unsigned char *tags = image + SET_HEADER_SIZE, *payloads = tags + set->n_slots * 4;
+	store_le32(tags + slot * 4, set_tag(set_hash(payload, set->n_payload, set->seed)));
+	memcpy(payloads + slot * set->n_payload, payload, set->n_payload);
+	++set->n_items;
+}
+
+int base58check_set_build(struct base58check_set *restrict set, const struct base58check_item in[], size_t n_items, size_t n_payload, int results[]) {
+	if (n_payload == 0 || n_payload > BASE58CHECK_SET_MAX_PAYLOAD)
+		return BASE58CHECK_ESIZE;
+	// keep the table at least a quarter empty
+	size_t n_slots = 1, n_min = n_items + n_items / 3 + 1, n_image;
+	while (n_slots < n_min)
+		if (__builtin_uaddl_overflow(n_slots, n_slots, &n_slots))
+			return BASE58CHECK_ESIZE;
+	if (__builtin_umull_overflow(n_slots, 4 + n_payload, &n_image) ||
+			__builtin_uaddl_overflow(n_image, SET_HEADER_SIZE, &n_image))
+		return BASE58CHECK_ESIZE;
+	unsigned char *image = base58check_malloc(n_image);
+	// the batch arrays are too large for the stacks of some worker threads
+	size_t *offsets = base58check_malloc((SET_BATCH + 1) * sizeof *offsets);
+	int *batch_results = base58check_malloc(SET_BATCH * sizeof *batch_results), ret = BASE58CHECK_ENOMEM;
+	if (!image || !offsets || !batch_results) {
+		if (image)
+			base58check_free(image);
+		goto done;
+	}
+	memset(image, 0, n_image);
+	*set = (struct base58check_set) { .image = image, .n_image = n_image, .n_payload = n_payload, .n_slots = n_slots, .seed = UINT64_C(0x42353843534554), .owner = 1 };
+
+	for (size_t i = 0; i < n_items; i += SET_BATCH) {
+		size_t n_batch = n_items - i < SET_BATCH ? n_items - i : SET_BATCH, n_out = 0;
+		unsigned char *out = NULL;
+		if ((ret = base58check_decode_batch(&out, &n_out, offsets, batch_results, in + i, n_batch)) < 0) {
+			base58check_set_free(set);
+			goto done;
+		}
+		for (size_t j = 0; j < n_batch; ++j) {
+			if ((ret = batch_results[j]) == 0 && offsets[j + 1] - offsets[j] != n_payload)
+				ret = BASE58CHECK_ELENGTH;
+			if (results)
+				results[i + j] = ret;
+			else if (ret < 0) {
+				base58check_free(out);
+				base58check_set_free(set);
+				goto done;
+			}
+			if (ret == 0)
+				set_insert(set, image, out + offsets[j]);
+		}
+		base58check_free(out);
+	}
+	ret = 0;
+
+	memcpy(image, SET_MAGIC, 8);
+	store_le64(image + 8, n_payload);
+	store_le64(image + 16, set->n_items);
+	store_le64(image + 24, n_slots);
+	store_le64(image + 32, set->seed);
+
+done:
+	if (offsets)
+		base58check_free(offsets);
+	if (batch_results)
+		base58check_free(batch_results);
+	return ret;
+}
+
+int base58check_set_open(struct base58check_set *restrict set, const void *image, size_t n_image) {
+	const unsigned char *p = image;
+	if (n_image < SET_HEADER_SIZE || memcmp(p, SET_MAGIC, 8))
+		return BASE58CHECK_EFORMAT;
+	uint64_t n_payload = load_le64(p + 8), n_items = load_le64(p + 16), n_slots = load_le64(p + 24);
+	if (n_payload == 0 || n_payload > BASE58CHECK_SET_MAX_PAYLOAD ||
+			n_slots == 0 || n_slots & n_slots - 1 || n_items >= n_slots ||
+			n_slots > (n_image - SET_HEADER_SIZE) / (4 + n_payload) ||
+			n_image != SET_HEADER_SIZE + n_slots * (4 + n_payload))
+		return BASE58CHECK_EFORMAT;
+	*set = (struct base58check_set) { .image = p, .n_image = n_image, .n_payload = n_payload, .n_items = n_items, .n_slots = n_slots, .seed = load_le64(p + 32) };
+	return 0;
+}
+
+int base58check_set_map(struct base58check_set *restrict set, const char *restrict path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return BASE58CHECK_EIO;
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return BASE58CHECK_EIO;
+	}
+	size_t n_image = (size_t) st.st_size;
+	if (st.st_size < SET_HEADER_SIZE || (off_t) n_image != st.st_size) {
+		close(fd);
+		return BASE58CHECK_EFORMAT;
+	}
+	void *image = mmap(NULL, n_image, PROT_READ, MAP_SHARED, fd, 0);
+	int err = errno;
+	close(fd);
+	if (image == MAP_FAILED) {
+		errno = err;
+		return BASE58CHECK_EIO;
+	}
+	int ret = base58check_set_open(set, image, n_image);
+	if (ret < 0) {
+		munmap(image, n_image);
+		return ret;
+	}
+	// lookups land anywhere, so reading ahead would only waste the cache
+	madvise(image, n_image, MADV_RANDOM);
+	set->owner = 2;
+	return 0;
+}
+
+int base58check_set_save(const struct base58check_set *restrict set, const char *restrict path) {
+	size_t n_path = strlen(path);
+	char *tmp = base58check_malloc(n_path + sizeof ".XXXXXX");
+	if (!tmp)
+		return BASE58CHECK_ENOMEM;
+	memcpy(tmp, path, n_path);
+	memcpy(tmp + n_path, ".XXXXXX", sizeof ".XXXXXX");
+	int fd = mkstemp(tmp);
+	if (fd < 0) {
+		int err = errno;
+		base58check_free(tmp);
+		errno = err;
+		return BASE58CHECK_EIO;
+	}
+	const unsigned char *p = set->image;
+	size_t n = set->n_image;
+	while (n) {
+		ssize_t w = write(fd, p, n);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		p += w, n -= (size_t) w;
+	}
+	// the descriptor is closed whatever fails, and errno tells of the first
+	// failure
+	int err = errno;
+	bool ok = !n;
+	if (ok && fchmod(fd, 0644) < 0)
+		ok = false, err = errno;
+	if (close(fd) < 0 && ok)
+		ok = false, err = errno;
+	if (ok && rename(tmp, path) < 0)
+		ok = false, err = errno;
+	if (!ok)
+		unlink(tmp);
+	base58check_free(tmp);
+	if (!ok) {
+		errno = err;
+		return BASE58CHECK_EIO;
+	}
+	return 0;
+}
+
+void base58check_set_free(struct base58check_set *set) {
+	if (set->owner == 1)
+		base58check_free((void *) (uintptr_t) set->image);
+	else if (set->owner == 2)
+		munmap((void *) (uintptr_t) set->image, set->n_image);
+	*set = (struct base58check_set) { };
+}
+
+int base58check_set_contains(const struct base58check_set *restrict set, const char *restrict in, size_t n_in) {
+	unsigned char payload[BASE58CHECK_SET_MAX_PAYLOAD];
+	int ret = base58check_decode_expect(payload, set->n_payload, in, n_in, NULL, 0);
+	if (ret < 0)
+		return ret;
+	bool found;
+	set_probe(set, payload, &found);
+	return found;
+}
+
+int base58check_set_contains_payload(const struct base58check_set *restrict set, const unsigned char *restrict payload, size_t n_payload) {
+	if (n_payload != set->n_payload)
+		return 0;
+	bool found;
+	set_probe(set, payload, &found);
+	return found;
+}
+
+__attribute__ ((__const__))
+static inline size_t leb128_size(size_t n) {
+	size_t size = 1;
+	while (n >>= 7)
+		++size;
+	return size;
+}
+
+static unsigned char * leb128_put(unsigned char *p, size_t n) {
+	for (; n >= 0x80; n >>= 7)
+		*p++ = (unsigned char) (n | 0x80);
+	*p++ = (unsigned char) n;
+	return p;
+}
+
+// Reads the size prefix of the record at *p, advancing *p past it to the
+// payload. Returns false if the prefix or the payload runs past end.
+static bool pack_read_size(const unsigned char **p, const unsigned char *end, size_t *n) {
+	size_t size = 0;
+	for (unsigned shift = 0;; shift += 7) {
+		if (*p == end || shift >= sizeof size * 8)
+			return false;
+		unsigned char b = *(*p)++;
+		size |= (size_t) (b & 0x7F) << shift;
+		if (!(b & 0x80))
+			break;
+	}
+	if (size > (size_t) (end - *p))
+		return false;
+	*n = size;
+	return true;
+}
+
+size_t base58check_pack_batch_buffer_size(const struct base58check_item in[], size_t n_items, unsigned flags) {
+	size_t n_need = PACK_HEADER_SIZE;
+	for (size_t i = 0; i < n_items; ++i) {
+		size_t n_item = base58check_decode_buffer_size(in[i].data, in[i].size, 0);
+		if (n_item == SIZE_MAX || __builtin_uaddl_overflow(n_need, n_item + leb128_size(n_item), &n_need))
+			return SIZE_MAX;
+	}
+	// the index is aligned to its words
+	if (flags & BASE58CHECK_PACK_INDEX && (n_items >= SIZE_MAX / 8 ||
+			__builtin_uaddl_overflow(n_need, (n_items + 1) * 8 + 7, &n_need)))
+		return SIZE_MAX;
+	return n_need;
+}
+
+int base58check_pack_batch(unsigned char **restrict out, size_t *restrict n_out, const struct base58check_item in[], size_t n_items, unsigned flags, int results[]) {
+	size_t n_need = base58check_pack_batch_buffer_size(in, n_items, flags);
+	if (n_need == SIZE_MAX)
+		return BASE58CHECK_ESIZE;
+	unsigned char *out_ = *out;
+	size_t n_out_ = *n_out;
+	if (!out_) {
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_))
+			return BASE58CHECK_ESIZE;
+		if (!(out_ = base58check_malloc(n_out_)))
+			return BASE58CHECK_ENOMEM;
+	}
+	else if (n_out_ < n_need)
+		return BASE58CHECK_ESIZE;
+
+	size_t *offsets = base58check_malloc((n_items + 1) * sizeof *offsets);
+	int *results_ = results ?: base58check_malloc((n_items ?: 1) * sizeof *results_), ret = BASE58CHECK_ENOMEM;
+	unsigned char *records = out_ + PACK_HEADER_SIZE;
+	size_t n_records = n_out_ - PACK_HEADER_SIZE;
+	if (!offsets || !results_ ||
+			(ret = base58check_decode_batch(&records, &n_records, offsets, results_, in, n_items)) < 0)
+		goto fail;
+
+	// the payloads are back to back; see whether they are all the same size
+	size_t n_valid = 0, record_size = 0, n_bytes = n_records;
+	bool variable = false;
+	for (size_t i = 0; i < n_items; ++i) {
+		if (results_[i] < 0) {
+			if (!results) {
+				ret = results_[i];
+				goto fail;
+			}
+			continue;
+		}
+		size_t size = offsets[i + 1] - offsets[i];
+		if (n_valid++ == 0)
+			record_size = size;
+		else if (size != record_size)
+			variable = true;
+	}
+	// empty payloads are prefixed too, so that the number of records in a
+	// pack is bounded by its size
+	if (n_valid && !record_size)
+		variable = true;
+
+	uint64_t pack_flags = 0;
+	size_t n_pack = PACK_HEADER_SIZE + n_bytes, index_offset = 0;
+	if (variable) {
+		// Spread the payloads out from the back to make room for their
+		// prefixes. Each moves right, so it never lands on one yet to move.
+		for (size_t i = 0; i < n_items; ++i)
+			if (results_[i] == 0)
+				n_bytes += leb128_size(offsets[i + 1] - offsets[i]);
+		pack_flags = PACK_VARIABLE;
+		n_pack = PACK_HEADER_SIZE + n_bytes;
+		unsigned char *index = NULL;
+		if (flags & BASE58CHECK_PACK_INDEX) {
+			index_offset = (n_pack + 7) & ~(size_t) 7;
+			memset(out_ + n_pack, 0, index_offset - n_pack);
+			index = out_ + index_offset;
+			store_le64(index + n_valid * 8, n_bytes);
+			pack_flags |= PACK_INDEXED;
+			n_pack = index_offset + (n_valid + 1) * 8;
+		}
+		unsigned char *end = records + n_bytes;
+		for (size_t i = n_items, k = n_valid; i--;)
+			if (results_[i] == 0) {
+				size_t size = offsets[i + 1] - offsets[i];
+				end -= size;
+				memmove(end, records + offsets[i], size);
+				end -= leb128_size(size);
+				leb128_put(end, size);
+				if (index)
+					store_le64(index + --k * 8, (uint64_t) (end - records));
+			}
+	}
+
+	memset(out_, 0, PACK_HEADER_SIZE);
+	memcpy(out_, PACK_MAGIC, 8);
+	store_le64(out_ + 8, n_valid);
+	store_le64(out_ + 16, variable ? 0 : record_size);
+	store_le64(out_ + 24, pack_flags);
+	store_le64(out_ + 32, n_bytes);
+	store_le64(out_ + 40, index_offset);
+	base58check_free(offsets);
+	if (!results)
+		base58check_free(results_);
+	*out = out_;
+	*n_out = n_pack;
+	return 0;
+
+fail:
+	if (offsets)
+		base58check_free(offsets);
+	if (!results && results_)
+		base58check_free(results_);
+	if (!*out)
+		base58check_free(out_);
+	return ret;
+}
+
+int base58check_pack_open(struct base58check_pack *restrict pack, const void *image, size_t n_image) {
+	const unsigned char *p = image;
+	if (n_image < PACK_HEADER_SIZE || memcmp(p, PACK_MAGIC, 8))
+		return BASE58CHECK_EFORMAT;
+	uint64_t n_records = load_le64(p + 8), record_size = load_le64(p + 16), flags = load_le64(p + 24),
+			n_bytes = load_le64(p + 32), index_offset = load_le64(p + 40);
+	if (flags & ~(uint64_t) (PACK_VARIABLE | PACK_INDEXED) ||
+			n_bytes > n_image - PACK_HEADER_SIZE)
+		return BASE58CHECK_EFORMAT;
+#if SIZE_MAX < UINT64_MAX
+	if (n_records > SIZE_MAX)
+		return BASE58CHECK_EFORMAT;
+#endif
+	if (flags & PACK_VARIABLE) {
+		// every record has a prefix of at least one byte
+		if (record_size || n_records > n_bytes)
+			return BASE58CHECK_EFORMAT;
+	}
+	else if (flags & PACK_INDEXED || (record_size ? n_records != n_bytes / record_size || n_bytes % record_size : n_bytes || n_records))
+		return BASE58CHECK_EFORMAT;
+	if (flags & PACK_INDEXED ? index_offset % 8 || index_offset < PACK_HEADER_SIZE + n_bytes || index_offset > n_image ||
+			n_records >= (n_image - index_offset) / 8 : index_offset)
+		return BASE58CHECK_EFORMAT;
+	*pack = (struct base58check_pack) {
+		.image = p, .records = p + PACK_HEADER_SIZE, .index = flags & PACK_INDEXED ? p + index_offset : NULL,
+		.n_image = n_image, .n_records = n_records, .record_size = record_size, .n_bytes = n_bytes, .flags = (unsigned) flags,
+	};
+	return 0;
+}
+
+int base58check_pack_record(const struct base58check_pack *restrict pack, size_t i, const unsigned char **restrict payload, size_t *restrict n_payload) {
+	if (i >= pack->n_records)
+		return BASE58CHECK_ESIZE;
+	if (!(pack->flags & PACK_VARIABLE)) {
+		*payload = pack->records + i * pack->record_size;
+		*n_payload = pack->record_size;
+		return 0;
+	}
+	const unsigned char *p = pack->records, *end = p + pack->n_bytes;
+	size_t size;
+	if (pack->index) {
+		uint64_t offset = load_le64(pack->index + i * 8);
+		if (offset >= pack->n_bytes)
+			return BASE58CHECK_EFORMAT;
+		p += offset;
+	}
+	else
+		for (; i; --i, p += size)
+			if (!pack_read_size(&p, end, &size))
+				return BASE58CHECK_EFORMAT;
+	if (!pack_read_size(&p, end, &size))
+		return BASE58CHECK_EFORMAT;
+	*payload = p;
+	*n_payload = size;
+	return 0;
+}
+
+// the most characters that a record of n bytes can unpack to, with its newline
+static inline size_t unpack_record_bound(size_t n) {
+	size_t n_out = encoded_size_upper_bound(n + 4);
+	return n_out == SIZE_MAX ? SIZE_MAX : n_out + 1;
+}
+
+struct unpack_state {
+	const struct base58check_pack *pack;
+	char *out;
+	// for each run, the start of its first record and the offset and size of
+	// its part of the output; bounds has an extra element for the end
+	const unsigned char **starts;
+	size_t *bounds, *sizes, n_runs;
+	size_t next; // the next run to be claimed
+	int error;
+};
+
+// Works out where each run of records starts in the pack and in the output,
+// and the size of the whole output. starts and bounds may be null.
+static int unpack_plan(const struct base58check_pack *pack, const unsigned char **starts, size_t *bounds, size_t *n_need) {
+	size_t n_out = 0;
+	if (!(pack->flags & PACK_VARIABLE)) {
+		size_t bound = unpack_record_bound(pack->record_size);
+		if (bound == SIZE_MAX || __builtin_umull_overflow(bound, pack->n_records, &n_out))
+			return BASE58CHECK_ESIZE;
+		if (bounds)
+			for (size_t r = 0; r * UNPACK_RUN < pack->n_records; ++r)
+				bounds[r] = r * UNPACK_RUN * bound;
+	}
+	else {
+		const unsigned char *p = pack->records, *end = p + pack->n_bytes;
+		for (size_t i = 0; i < pack->n_records; ++i) {
+			if (i % UNPACK_RUN == 0) {
+				if (starts)
+					starts[i / UNPACK_RUN] = p;
+				if (bounds)
+					bounds[i / UNPACK_RUN] = n_out;
+			}
+			size_t size;
+			if (!pack_read_size(&p, end, &size))
+				return BASE58CHECK_EFORMAT;
+			if (__builtin_uaddl_overflow(n_out, unpack_record_bound(size), &n_out))
+				return BASE58CHECK_ESIZE;
+			p += size;
+		}
+	}
+	if (bounds)
+		bounds[(pack->n_records + UNPACK_RUN - 1) / UNPACK_RUN] = n_out;
+	*n_need = n_out;
+	return 0;
+}
+
+size_t base58check_unpack_buffer_size(const struct base58check_pack *pack) {
+	size_t n_need;
+	return unpack_plan(pack, NULL, NULL, &n_need) < 0 ? SIZE_MAX : n_need;
+}
+
+static void * unpack_main(void *arg) {
+	struct unpack_state *st = arg;
+	const struct base58check_pack *pack = st->pack;
+	struct base58check_item *items = base58check_malloc(UNPACK_RUN * sizeof *items);
+	size_t *offsets = base58check_malloc((UNPACK_RUN + 1) * sizeof *offsets);
+	if (!items || !offsets) {
+		__atomic_store_n(&st->error, BASE58CHECK_ENOMEM, __ATOMIC_RELAXED);
+		goto done;
+	}
+	for (size_t r; (r = __atomic_fetch_add(&st->next, 1, __ATOMIC_RELAXED)) < st->n_runs;) {
+		size_t first = r * UNPACK_RUN, n = pack->n_records - first < UNPACK_RUN ? pack->n_records - first : UNPACK_RUN;
+		const unsigned char *p = st->starts ? st->starts[r] : NULL;
+		for (size_t j = 0; j < n; ++j)
+			if (p) {
+				// the plan has already checked every prefix
+				pack_read_size(&p, pack->records + pack->n_bytes, &items[j].size);
+				items[j].data = p, p += items[j].size;
+			}
+			else
+				items[j].data = pack->records + (first + j) * pack->record_size, items[j].size = pack->record_size;
+		char *part = st->out + st->bounds[r];
+		size_t n_part = st->bounds[r + 1] - st->bounds[r];
+		int ret = base58check_encode_batch(&part, &n_part, offsets, items, n);
+		if (ret < 0) {
+			__atomic_store_n(&st->error, ret, __ATOMIC_RELAXED);
+			break;
+		}
+		// move the encodings apart from the back to fit in their newlines
+		for (size_t j = n; j--;) {
+			memmove(part + offsets[j] + j, part + offsets[j], offsets[j + 1] - offsets[j]);
+			part[offsets[j + 1] + j] = '\n';
+		}
+		st->sizes[r] = offsets[n] + n;
+	}
+done:
+	if (items)
+		base58check_free(items);
+	if (offsets)
+		base58check_free(offsets);
+	return NULL;
+}
+
+int base58check_unpack(char **restrict out, size_t *restrict n_out, const struct base58check_pack *restrict pack, unsigned n_threads) {
+	struct unpack_state st = { .pack = pack, .n_runs = (pack->n_records + UNPACK_RUN - 1) / UNPACK_RUN };
+	if (!(st.bounds = base58check_malloc((st.n_runs + 1) * sizeof *st.bounds)) ||
+			!(st.sizes = base58check_malloc((st.n_runs ?: 1) * sizeof *st.sizes)) ||
+			(pack->flags & PACK_VARIABLE && !(st.starts = base58check_malloc((st.n_runs ?: 1) * sizeof *st.starts)))) {
+		st.error = BASE58CHECK_ENOMEM;
+		goto done;
+	}
+	size_t n_need;
+	if ((st.error = unpack_plan(pack, st.starts, st.bounds, &n_need)) < 0)
+		goto done;
+
+	char *out_ = *out;
+	size_t n_out_ = *n_out;
+	if (!out_) {
+		if (__builtin_uaddl_overflow(n_need, n_out_, &n_out_)) {
+			st.error = BASE58CHECK_ESIZE;
+			goto done;
+		}
+		if (!(out_ = base58check_malloc(n_out_ ?: 1))) {
+			st.error = BASE58CHECK_ENOMEM;
+			goto done;
+		}
+	}
+	else if (n_out_ < n_need) {
+		st.error = BASE58CHECK_ESIZE;
+		goto done;
+	}
+	st.out = out_;
+
+	// the calling thread encodes too, alongside as many others as can be
+	// started
+	long n_threads_ = n_threads ?: sysconf(_SC_NPROCESSORS_ONLN);
+	if ((size_t) n_threads_ > st.n_runs)
+		n_threads_ = (long) st.n_runs;
+	pthread_t *threads = n_threads_ > 1 ? base58check_malloc((size_t) (n_threads_ - 1) * sizeof *threads) : NULL;
+	size_t n_started = 0;
+	if (threads)
+		while (n_started < (size_t) (n_threads_ - 1) && !pthread_create(&threads[n_started], NULL, unpack_main, &st))
+			++n_started;
+	unpack_main(&st);
+	for (size_t i = 0; i < n_started; ++i)
+		pthread_join(threads[i], NULL);
+	if (threads)
+		base58check_free(threads);
+
+	if (st.error) {
+		if (!*out)
+			base58check_free(out_);
+		goto done;
+	}
+	// close up the parts, each of which is at or after where it belongs
+	size_t pos = 0;
+	for (size_t r = 0; r < st.n_runs; ++r) {
+		memmove(out_ + pos, out_ + st.bounds[r], st.sizes[r]);
+		pos += st.sizes[r];
+	}
+	*out = out_;
+	*n_out = pos;
+
+done:
+	if (st.bounds)
+		base58check_free(st.bounds);
+	if (st.sizes)
+		base58check_free(st.sizes);
+	if (st.starts)
+		base58check_free(st.starts);
+	return st.error;
 }
 
 
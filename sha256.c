@@ -0,0 +1,198 @@
+#include "sha256.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__has_attribute)
+# if __has_attribute(__target_clones__)
+// Messages are hashed 16 at a time. The lane vectors are held in 4 XMM
+// registers under SSE4.1, 2 YMM registers under AVX2, or 1 ZMM register under
+// AVX-512, whichever the running CPU supports.
+#  define SHA256_LANES 16
+# endif
+#endif
+
+#define _likely(...) __builtin_expect(!!(__VA_ARGS__), 1)
+
+
+#ifdef SHA256_LANES
+
+typedef uint32_t vec_t __attribute__ ((__vector_size__ (SHA256_LANES * sizeof(uint32_t))));
+
+static const uint32_t H0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) ((x) >> (n) | (x) << (32 - (n)))
+#define CH(x, y, z) ((x) & (y) ^ ~(x) & (z))
+#define MAJ(x, y, z) ((x) & (y) ^ (x) & (z) ^ (y) & (z))
+#define BSIG0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define BSIG1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SSIG0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ (x) >> 3)
+#define SSIG1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ (x) >> 10)
+
+static inline __attribute__ ((__always_inline__)) void compress(vec_t s[8], vec_t w[16]) {
+	vec_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+	for (unsigned t = 0; t < 64; ++t) {
+		if (t >= 16)
+			w[t & 15] += SSIG1(w[(t - 2) & 15]) + w[(t - 7) & 15] + SSIG0(w[(t - 15) & 15]);
+		vec_t t1 = h + BSIG1(e) + CH(e, f, g) + K[t] + w[t & 15], t2 = BSIG0(a) + MAJ(a, b, c);
+		h = g, g = f, f = e, e = d + t1, d = c, c = b, b = a, a = t1 + t2;
+	}
+	s[0] += a, s[1] += b, s[2] += c, s[3] += d, s[4] += e, s[5] += f, s[6] += g, s[7] += h;
+}
+
+static inline uint32_t load_be32(const unsigned char *p) {
+	return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+static inline void store_be32(unsigned char *p, uint32_t x) {
+	p[0] = (unsigned char) (x >> 24), p[1] = (unsigned char) (x >> 16), p[2] = (unsigned char) (x >> 8), p[3] = (unsigned char) x;
+}
+
+// Hashes n <= SHA256_LANES messages, one per lane. Lanes whose messages have
+// run out of blocks keep their states while the longer messages finish.
+__attribute__ ((__target_clones__ ("avx512f", "avx2", "sse4.1", "default")))
+static void sha256d_lanes(unsigned char (*restrict out)[32], const unsigned char *const in[], const size_t n_in[], size_t n) {
+	static const unsigned char zeros[64];
+	size_t n_blocks[SHA256_LANES], max_blocks = 0;
+	for (size_t l = 0; l < SHA256_LANES; ++l)
+		if ((n_blocks[l] = l < n ? (n_in[l] + 9 + 63) / 64 : 0) > max_blocks)
+			max_blocks = n_blocks[l];
+
+	vec_t s[8], w[16];
+	for (size_t i = 0; i < 8; ++i)
+		s[i] = (vec_t) { } + H0[i];
+	for (size_t b = 0; b < max_blocks; ++b) {
+		unsigned char pad[SHA256_LANES][64];
+		vec_t active;
+		for (size_t l = 0; l < SHA256_LANES; ++l) {
+			const unsigned char *p = zeros;
+			active[l] = b < n_blocks[l] ? ~UINT32_C(0) : 0;
+			if (_likely(active[l])) {
+				size_t off = b * 64;
+				if (_likely(n_in[l] >= off + 64))
+					p = in[l] + off;
+				else {
+					p = memset(pad[l], 0, 64);
+					if (n_in[l] >= off) {
+						memcpy(pad[l], in[l] + off, n_in[l] - off);
+						pad[l][n_in[l] - off] = 0x80;
+					}
+					if (b == n_blocks[l] - 1) {
+						store_be32(pad[l] + 56, (uint32_t) (n_in[l] >> 29));
+						store_be32(pad[l] + 60, (uint32_t) (n_in[l] << 3));
+					}
+				}
+			}
+			for (size_t j = 0; j < 16; ++j)
+				w[j][l] = load_be32(p + j * 4);
+		}
+		vec_t t[8];
+		memcpy(t, s, sizeof t);
+		compress(t, w);
+		for (size_t i = 0; i < 8; ++i)
+			s[i] = t[i] & active | s[i] & ~active;
+	}
+
+	// the 32-byte digests fill exactly one block of the outer hash
+	for (size_t i = 0; i < 8; ++i)
+		w[i] = s[i], s[i] = (vec_t) { } + H0[i];
+	w[8] = (vec_t) { } + 0x80000000;
+	for (size_t i = 9; i < 15; ++i)
+		w[i] = (vec_t) { };
+	w[15] = (vec_t) { } + 256;
+	compress(s, w);
+
+	for (size_t l = 0; l < n; ++l)
+		for (size_t i = 0; i < 8; ++i)
+			store_be32(out[l] + i * 4, s[i][l]);
+}
+
+#endif // defined(SHA256_LANES)
+
+// As of OpenSSL 3.0, the one-shot SHA256() fetches the algorithm and allocates
+// a digest context on every call. The low-level interface does neither.
+#if defined(OPENSSL_NO_DEPRECATED_3_0)
+
+void sha256d(unsigned char out[32], const unsigned char *in, size_t n_in) {
+	SHA256(in, n_in, out);
+	SHA256(out, 32, out);
+}
+
+void sha256_midstate_init(struct sha256_midstate *restrict state, const unsigned char *restrict prefix, size_t n_prefix) {
+	state->prefix = prefix, state->n_prefix = n_prefix;
+}
+
+void sha256d_finish(unsigned char out[restrict 32], const struct sha256_midstate *restrict state, const unsigned char *restrict in, size_t n_in) {
+	EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+	if (ctx && EVP_DigestInit_ex(ctx, EVP_sha256(), NULL) &&
+			EVP_DigestUpdate(ctx, state->prefix, state->n_prefix) &&
+			EVP_DigestUpdate(ctx, in, n_in) &&
+			EVP_DigestFinal_ex(ctx, out, NULL))
+		SHA256(out, 32, out);
+	else
+		memset(out, 0, 32);
+	EVP_MD_CTX_free(ctx);
+}
+
+#else
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+void sha256d(unsigned char out[32], const unsigned char *in, size_t n_in) {
+	SHA256_CTX ctx;
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, in, n_in);
+	SHA256_Final(out, &ctx);
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, out, 32);
+	SHA256_Final(out, &ctx);
+}
+
+void sha256_midstate_init(struct sha256_midstate *restrict state, const unsigned char *restrict prefix, size_t n_prefix) {
+	SHA256_Init(&state->ctx);
+	SHA256_Update(&state->ctx, prefix, n_prefix);
+}
+
+void sha256d_finish(unsigned char out[restrict 32], const struct sha256_midstate *restrict state, const unsigned char *restrict in, size_t n_in) {
+	SHA256_CTX ctx = state->ctx;
+	SHA256_Update(&ctx, in, n_in);
+	SHA256_Final(out, &ctx);
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, out, 32);
+	SHA256_Final(out, &ctx);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+void sha256d_many(unsigned char (*restrict out)[32], const unsigned char *const in[], const size_t n_in[], size_t n) {
+#ifdef SHA256_LANES
+	if (n > 1) {
+		while (n) {
+			size_t m = n < SHA256_LANES ? n : SHA256_LANES;
+			sha256d_lanes(out, in, n_in, m);
+			out += m, in += m, n_in += m, n -= m;
+		}
+		return;
+	}
+#endif
+	for (size_t i = 0; i < n; ++i)
+		sha256d(out[i], in[i], n_in[i]);
+}
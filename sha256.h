@@ -0,0 +1,43 @@
+#include <stddef.h>
+#include <openssl/sha.h>
+
+#define _hidden __attribute__ ((__visibility__ ("hidden")))
+
+/*
+ * Computes the double SHA-256 hash of one message without allocating.
+ */
+_hidden void sha256d(unsigned char out[32], const unsigned char *in, size_t n_in)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__));
+
+/*
+ * Computes the double SHA-256 hashes of n independent messages. Messages are
+ * hashed in parallel lanes of SIMD vectors where the CPU supports it and one
+ * at a time through OpenSSL otherwise.
+ */
+_hidden void sha256d_many(unsigned char (*restrict out)[32], const unsigned char *const in[], const size_t n_in[], size_t n)
+	__attribute__ ((__access__ (write_only, 1, 4), __access__ (read_only, 2, 4), __access__ (read_only, 3, 4), __nonnull__, __nothrow__));
+
+/*
+ * The state of SHA-256 after absorbing a fixed message prefix, from which the
+ * double SHA-256 hashes of any number of messages that begin with that prefix
+ * can be finished without absorbing the prefix again. Where OpenSSL lacks the
+ * low-level interface, the state merely refers to the prefix, which must then
+ * outlive it.
+ */
+struct sha256_midstate {
+#if defined(OPENSSL_NO_DEPRECATED_3_0)
+	const unsigned char *prefix;
+	size_t n_prefix;
+#else
+	SHA256_CTX ctx;
+#endif
+};
+
+_hidden void sha256_midstate_init(struct sha256_midstate *restrict state, const unsigned char *restrict prefix, size_t n_prefix)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__));
+
+/*
+ * Computes the double SHA-256 hash of the state's prefix followed by in.
+ */
+_hidden void sha256d_finish(unsigned char out[restrict 32], const struct sha256_midstate *restrict state, const unsigned char *restrict in, size_t n_in)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2), __access__ (read_only, 3, 4), __nonnull__, __nothrow__));
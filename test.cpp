@@ -1,7 +1,13 @@
 #include "base58check.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <gmp.h>
 #include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <unistd.h>
 
 
 template <typename T, size_t N>
@@ -15,9 +21,12 @@ static void test_round_trip(const char str[], size_t decoded_size) {
 	assert(bytes.size() == decoded_size);
 	auto out = base58check::encode(bytes.data(), bytes.size(), 0);
 	assert(out == str);
+	size_t n_decoded = 0;
+	assert(::base58check_verify(str, std::strlen(str), &n_decoded) == 0 && n_decoded == decoded_size);
 }
 
 static void test_invalid(const char str[]) {
+	assert(!base58check::is_valid(str, std::strlen(str)));
 	try {
 		base58check::decode(str, 0);
 	}
@@ -27,6 +36,860 @@ static void test_invalid(const char str[]) {
 	throw std::logic_error("should have thrown");
 }
 
+static void test_encode_batch() {
+	static const char *const strs[] = {
+		"3QJmnh", "1111111111111111111114oLvT2", "1BitcoinEaterAddressDontSendf59kuE",
+	};
+	std::vector<std::vector<base58check::byte>> payloads;
+	std::vector<::base58check_item> items;
+	for (size_t i = 0; i < 40; ++i)
+		payloads.push_back(base58check::decode(strs[i % 3], std::strlen(strs[i % 3])));
+	for (auto &payload : payloads)
+		items.push_back({ payload.data(), payload.size() });
+	std::vector<size_t> offsets;
+	auto out = base58check::encode(items.data(), items.size(), offsets);
+	assert(offsets.size() == items.size() + 1 && offsets.front() == 0 && offsets.back() == out.size());
+	for (size_t i = 0; i < items.size(); ++i)
+		assert(out.compare(offsets[i], offsets[i + 1] - offsets[i], strs[i % 3]) == 0);
+}
+
+static void test_batch_lengths() {
+	// lengths straddling SHA-256 block boundaries, in groups of mixed sizes
+	std::vector<std::vector<base58check::byte>> payloads;
+	std::vector<::base58check_item> items;
+	for (size_t n = 0; n < 150; ++n) {
+		payloads.emplace_back(n + 1); // never empty, so data() is not null
+		payloads.back().pop_back();
+		for (size_t i = 0; i < n; ++i)
+			payloads.back()[i] = static_cast<base58check::byte>((i + 1) * (n + 3) * 2654435761u >> 24);
+	}
+	for (auto &payload : payloads)
+		items.push_back({ payload.data(), payload.size() });
+	std::vector<size_t> offsets;
+	auto out = base58check::encode(items.data(), items.size(), offsets);
+	std::vector<::base58check_item> encodings;
+	for (size_t i = 0; i < items.size(); ++i) {
+		const auto &payload = payloads[i];
+		assert(out.compare(offsets[i], offsets[i + 1] - offsets[i], base58check::encode(payload.data(), payload.size())) == 0);
+		encodings.push_back({ out.data() + offsets[i], offsets[i + 1] - offsets[i] });
+	}
+	std::vector<size_t> decoded_offsets;
+	std::vector<int> results;
+	auto decoded = base58check::decode(encodings.data(), encodings.size(), decoded_offsets, results);
+	for (size_t i = 0; i < items.size(); ++i) {
+		assert(results[i] == 0 && decoded_offsets[i + 1] - decoded_offsets[i] == payloads[i].size());
+		assert(std::equal(payloads[i].begin(), payloads[i].end(), decoded.begin() + decoded_offsets[i]));
+	}
+}
+
+static void test_decode_batch() {
+	static const char *const strs[] = {
+		"3QJmnh", "1BitcoinEaterAddressDontSendf59kuF", "1111111111111111111114oLvT2",
+		"", "1BitcoinEaterAddressDontSendf59kuE", "0OIl",
+	};
+	static const int expect[] = {
+		0, BASE58CHECK_ECHECKSUM, 0, BASE58CHECK_ELENGTH, 0, BASE58CHECK_ECHAR,
+	};
+	std::vector<::base58check_item> items;
+	for (size_t i = 0; i < 50; ++i)
+		items.push_back({ strs[i % 6], std::strlen(strs[i % 6]) });
+	std::vector<size_t> offsets;
+	std::vector<int> results;
+	auto out = base58check::decode(items.data(), items.size(), offsets, results);
+	assert(offsets.back() == out.size());
+	for (size_t i = 0; i < items.size(); ++i) {
+		assert(results[i] == expect[i % 6]);
+		if (results[i] == 0) {
+			auto bytes = base58check::decode(strs[i % 6], std::strlen(strs[i % 6]));
+			assert(offsets[i + 1] - offsets[i] == bytes.size());
+			assert(std::equal(bytes.begin(), bytes.end(), out.begin() + offsets[i]));
+		}
+		else
+			assert(offsets[i + 1] == offsets[i]);
+	}
+}
+
+#if __cplusplus >= 201703L
+
+template <size_t N>
+static void test_fixed(const char str[]) {
+	auto bytes = base58check::fixed_decoder<N>::decode(str);
+	auto expect = base58check::decode(str);
+	assert(expect.size() == N && std::equal(expect.begin(), expect.end(), bytes.begin()));
+	assert(std::string_view(base58check::fixed_encoder<N>::encode(bytes)) == str);
+}
+
+template <size_t N>
+static void test_fixed_round_trip() {
+	std::array<base58check::byte, N> bytes;
+	for (unsigned seed = 0; seed < 64; ++seed) {
+		for (size_t i = 0; i < N; ++i)
+			bytes[i] = static_cast<base58check::byte>(i < seed % 4 ? 0 : (i + 1) * (seed + 7) * 2654435761u >> 24);
+		auto encoded = base58check::fixed_encoder<N>::encode(bytes);
+		assert(std::string_view(encoded) == base58check::encode(bytes));
+		std::array<base58check::byte, N> decoded;
+		assert(base58check::fixed_decoder<N>::decode(decoded, encoded.data(), encoded.size) == 0 && decoded == bytes);
+	}
+}
+
+#if __cplusplus >= 202002L
+
+template <size_t N>
+static void test_encode_constant() {
+	static constexpr auto in = [] {
+		std::array<base58check::byte, N> ret { };
+		for (size_t i = N / 8; i < N; ++i)
+			ret[i] = static_cast<base58check::byte>(i * 73 + 5);
+		return ret;
+	}();
+	constexpr auto encoded = base58check::encode_constant(in);
+	assert(std::string_view(encoded) == std::string_view(base58check::fixed_encoder<N>::encode(in)));
+}
+
+static void test_constant() {
+	// the hash boundaries of one and two blocks are crossed at 55, 56, and 64 bytes
+	test_encode_constant<0>();
+	test_encode_constant<21>();
+	test_encode_constant<51>();
+	test_encode_constant<52>();
+	test_encode_constant<60>();
+	test_encode_constant<78>();
+	test_encode_constant<200>();
+
+#if __cpp_consteval >= 201811L && __cpp_nontype_template_args >= 201911L
+	using namespace base58check::literals;
+	constexpr auto eater = "1BitcoinEaterAddressDontSendf59kuE"_b58c;
+	static_assert(eater.size() == 21);
+	static_assert(std::string_view(base58check::encode_constant(eater)) == "1BitcoinEaterAddressDontSendf59kuE");
+	auto decoded = base58check::decode("1BitcoinEaterAddressDontSendf59kuE");
+	assert(std::equal(eater.begin(), eater.end(), decoded.begin(), decoded.end()));
+	static_assert("3QJmnh"_b58c.size() == 0);
+	static_assert("1111111111111111111114oLvT2"_b58c == std::array<base58check::byte, 21> { });
+#endif
+}
+
+#endif // __cplusplus >= 202002L
+
+static void test_fixed_invalid() {
+	std::array<base58check::byte, 21> out;
+	static const char bad_checksum[] = "1BitcoinEaterAddressDontSendf59kuF";
+	assert(base58check::fixed_decoder<21>::decode(out, bad_checksum, sizeof bad_checksum - 1) == BASE58CHECK_ECHECKSUM);
+	static const char bad_char[] = "1BitcoinEaterAddressDontSendf59ku0";
+	assert(base58check::fixed_decoder<21>::decode(out, bad_char, sizeof bad_char - 1) == BASE58CHECK_ECHAR);
+	static const char short_[] = "3QJmnh";
+	assert(base58check::fixed_decoder<21>::decode(out, short_, sizeof short_ - 1) == BASE58CHECK_ELENGTH);
+	static const char long_[] = "11111111111111111111111111111111111111111111111111";
+	assert(base58check::fixed_decoder<21>::decode(out, long_, sizeof long_ - 1) == BASE58CHECK_ELENGTH);
+}
+
+static void test_decode_as() {
+	using p2pkh = base58check::format<21, 0x00>;
+	using p2sh = base58check::format<21, 0x05>;
+	std::array<base58check::byte, 21> out, hash { base58check::byte { 0x05 } };
+	for (size_t i = 1; i < hash.size(); ++i)
+		hash[i] = static_cast<base58check::byte>(i * 37);
+	std::string script(base58check::fixed_encoder<21>::encode(hash));
+	static const char eater[] = "1BitcoinEaterAddressDontSendf59kuE";
+
+	assert(base58check::decode_as<p2pkh>(out, eater) == 0);
+	auto decoded = base58check::decode(eater);
+	assert(std::equal(out.begin(), out.end(), decoded.begin(), decoded.end()));
+	assert(base58check::decode_as<p2sh>(script) == hash);
+	assert(base58check::decode_as<p2sh>(out, eater) == BASE58CHECK_EVERSION);
+	assert(base58check::decode_as<p2pkh>(out, script) == BASE58CHECK_EVERSION);
+	assert(base58check::decode_as<p2pkh>(out, "1BitcoinEaterAddressDontSendf59kuF") == BASE58CHECK_ECHECKSUM);
+	assert(base58check::decode_as<p2pkh>(out, "1BitcoinEaterAddressDontSendf59ku0") == BASE58CHECK_ECHAR);
+	assert(base58check::decode_as<p2pkh>(out, "3QJmnh") == BASE58CHECK_ELENGTH);
+	using p2sh_long = base58check::format<22, 0x05>;
+	std::array<base58check::byte, 22> longer;
+	assert(base58check::decode_as<p2sh_long>(longer, script) == BASE58CHECK_ELENGTH);
+	try {
+		base58check::decode_as<p2sh>(eater);
+		assert(false);
+	}
+	catch (const std::invalid_argument &e) {
+		assert(std::strstr(e.what(), "version"));
+	}
+
+	// the checks that decode_as() makes at compile time are left to the
+	// decoding here
+	unsigned char bytes[21];
+	static const unsigned char v5[] = { 0x05 }, v6[] = { 0x06 }, v00[] = { 0x00, 0x00 };
+	assert(::base58check_decode_expect(bytes, 21, script.data(), script.size(), v5, 1) == 0);
+	assert(std::memcmp(bytes, hash.data(), 21) == 0);
+	assert(::base58check_decode_expect(bytes, 21, script.data(), script.size(), v6, 1) == BASE58CHECK_EVERSION);
+	assert(::base58check_decode_expect(bytes, 21, eater, sizeof eater - 1, nullptr, 0) == 0);
+	assert(::base58check_decode_expect(bytes, 21, eater, sizeof eater - 1, v00, 2) == BASE58CHECK_EVERSION);
+	assert(::base58check_decode_expect(bytes, 20, eater, sizeof eater - 1, v00, 1) == BASE58CHECK_ELENGTH);
+	assert(::base58check_decode_expect(bytes, 1, eater, sizeof eater - 1, v00, 2) == BASE58CHECK_ESIZE);
+	static const char zeros[] = "1111111111111111111114oLvT2";
+	assert(::base58check_decode_expect(bytes, 21, zeros, sizeof zeros - 1, v00, 2) == 0);
+}
+
+#endif // __cplusplus >= 201703L
+
+static void test_context() {
+	base58check::context ctx;
+	static const char *const strs[] = {
+		"3QJmnh", "1111111111111111111114oLvT2", "1BitcoinEaterAddressDontSendf59kuE",
+	};
+	for (size_t i = 0; i < 9; ++i) {
+		auto bytes = ctx.decode(strs[i % 3], std::strlen(strs[i % 3]));
+		assert(ctx.encode(bytes.data(), bytes.size()) == strs[i % 3]);
+	}
+	unsigned char buf[32], *out = buf;
+	size_t n_out = sizeof buf;
+	static const char bad[] = "1BitcoinEaterAddressDontSendf59kuF";
+	assert(::base58check_decode_ctx(ctx.get(), &out, &n_out, bad, sizeof bad - 1, 0) == BASE58CHECK_ECHECKSUM);
+}
+
+// Every allocation made through the library's weak hooks is counted, so that
+// calls that should allocate nothing can be checked, and fails while
+// fail_hook_allocs is set.
+static size_t n_hook_allocs;
+static bool fail_hook_allocs;
+
+extern "C" void * base58check_malloc(size_t size) {
+	++n_hook_allocs;
+	return fail_hook_allocs ? nullptr : std::malloc(size);
+}
+
+extern "C" void base58check_free(void *ptr) {
+	std::free(ptr);
+}
+
+struct counting_allocator {
+	size_t n_allocs, n_live;
+};
+
+static void * counting_alloc(void *opaque, size_t size) {
+	counting_allocator *counts = static_cast<counting_allocator *>(opaque);
+	++counts->n_allocs, counts->n_live += size;
+	return std::malloc(size);
+}
+
+static void counting_free(void *opaque, void *ptr, size_t size) {
+	static_cast<counting_allocator *>(opaque)->n_live -= size;
+	std::free(ptr);
+}
+
+static void test_allocator() {
+	counting_allocator counts = { 0, 0 };
+	::base58check_allocator allocator = { counting_alloc, counting_free, &counts };
+	{
+		base58check::context ctx(allocator);
+		std::vector<base58check::byte> large(5000, base58check::byte(0x5a));
+		auto enc = ctx.encode(large.data(), large.size());
+		assert(ctx.decode(enc.data(), enc.size()) == large);
+		assert(counts.n_allocs > 1);
+
+		// a buffer allocated for the caller comes from the allocator too
+		size_t n_allocs = counts.n_allocs, n_live = counts.n_live;
+		unsigned char *out = nullptr;
+		size_t n_out = 0;
+		assert(::base58check_decode_ctx(ctx.get(), &out, &n_out, "3QJmnh", 6, 0) == 0 && n_out == 0);
+		assert(counts.n_allocs == n_allocs + 1);
+		counting_free(&counts, out, counts.n_live - n_live);
+	}
+	assert(counts.n_live == 0);
+}
+
+// checks the encoding of large inputs against a straightforward reference
+// computed by GMP, across the thresholds of the divide-and-conquer conversions
+static void test_large(size_t n, size_t n_leading_zeros) {
+	std::vector<unsigned char> bytes(n + 4);
+	for (size_t i = n_leading_zeros; i < n; ++i)
+		bytes[i] = static_cast<unsigned char>((i + 1) * (n + 11) * 2654435761u >> 24 | (i == n_leading_zeros));
+	::base58check_checksum(&bytes[n], bytes.data(), n);
+
+	mpz_t z;
+	mpz_init(z);
+	mpz_import(z, bytes.size(), 1, 1, 0, 0, bytes.data());
+	std::string expect(n_leading_zeros, '1');
+	char *digits = mpz_get_str(nullptr, 58, z);
+	for (const char *p = digits; *p; ++p)
+		expect += "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz"[
+			*p <= '9' ? *p - '0' : *p <= 'Z' ? *p - 'A' + 10 : *p - 'a' + 36];
+	void (*free_func)(void *, size_t);
+	mp_get_memory_functions(nullptr, nullptr, &free_func);
+	free_func(digits, std::strlen(digits) + 1);
+	mpz_clear(z);
+
+	auto actual = base58check::encode(reinterpret_cast<const base58check::byte *>(bytes.data()), n);
+	assert(actual == expect);
+	auto decoded = base58check::decode(actual.data(), actual.size());
+	assert(decoded.size() == n && std::memcmp(decoded.data(), bytes.data(), n) == 0);
+	size_t n_decoded = 0;
+	assert(::base58check_verify(actual.data(), actual.size(), &n_decoded) == 0 && n_decoded == n);
+	std::string inplace(n % 8, ' '); // vary the alignment of the buffer
+	inplace += actual;
+	assert(::base58check_decode_inplace(&inplace[n % 8], actual.size(), &n_decoded) == 0 && n_decoded == n &&
+			std::memcmp(&inplace[n % 8], bytes.data(), n) == 0);
+	actual[n_leading_zeros] = actual[n_leading_zeros] == '2' ? '3' : '2';
+	assert(::base58check_verify(actual.data(), actual.size(), nullptr) == BASE58CHECK_ECHECKSUM);
+}
+
+static void test_decode_inplace() {
+	static const char address[] = "1BitcoinEaterAddressDontSendf59kuE";
+	auto expect = base58check::decode(address, sizeof address - 1);
+	char buf[sizeof address];
+	std::memcpy(buf, address, sizeof buf);
+	size_t n_out = 0;
+	assert(::base58check_decode_inplace(buf, sizeof buf - 1, &n_out) == 0 && n_out == 21 &&
+			std::memcmp(buf, expect.data(), n_out) == 0);
+	std::memcpy(buf, "3QJmnh", 6);
+	assert(::base58check_decode_inplace(buf, 6, &n_out) == 0 && n_out == 0);
+
+	// rejected encodings are left as they were, short of a checksum mismatch
+	std::memcpy(buf, address, sizeof buf);
+	buf[10] = '0';
+	assert(::base58check_decode_inplace(buf, sizeof buf - 1, &n_out) == BASE58CHECK_ECHAR);
+	buf[10] = address[10];
+	assert(::base58check_decode_inplace(buf, 3, &n_out) == BASE58CHECK_ELENGTH && std::memcmp(buf, address, sizeof buf) == 0);
+	assert(::base58check_decode_inplace(buf, 0, &n_out) == BASE58CHECK_ELENGTH);
+	buf[sizeof buf - 2] = 'F';
+	assert(::base58check_decode_inplace(buf, sizeof buf - 1, &n_out) == BASE58CHECK_ECHECKSUM);
+
+	// long encodings take their scratch space from the library's hooks, so
+	// they fail cleanly without it, unless the library has no need of any
+	const std::vector<base58check::byte> large(2000, base58check::byte(0x3c));
+	const std::string enc = base58check::encode(large.data(), large.size());
+	std::string copy = enc;
+	fail_hook_allocs = true;
+	int ret = ::base58check_decode_inplace(&copy[0], copy.size(), &n_out);
+	fail_hook_allocs = false;
+	assert(ret == BASE58CHECK_ENOMEM ? copy == enc :
+			ret == 0 && n_out == large.size() && std::memcmp(copy.data(), large.data(), n_out) == 0);
+
+	std::string str(address);
+	const char *storage = str.data();
+	auto decoded = base58check::decode_inplace(std::move(str));
+	assert(decoded.data() == storage && decoded.size() == 21 && std::memcmp(decoded.data(), expect.data(), 21) == 0);
+	try {
+		base58check::decode_inplace(std::string("1BitcoinEaterAddressDontSendf59kuF"));
+	}
+	catch (const std::invalid_argument &) {
+		return;
+	}
+	throw std::logic_error("should have thrown");
+}
+
+static void test_address_set() {
+	std::vector<std::string> members, others;
+	for (unsigned i = 0; i < 3000; ++i) {
+		unsigned char payload[21] = { static_cast<unsigned char>(i % 3 ? 0 : 5) };
+		for (size_t j = 1; j < sizeof payload; ++j) {
+			uint64_t x = (i * sizeof payload + j) * UINT64_C(0x9e3779b97f4a7c15);
+			payload[j] = static_cast<unsigned char>((x ^ x >> 29) * UINT64_C(0xbf58476d1ce4e5b9) >> 56);
+		}
+		(i < 2000 ? members : others).push_back(base58check::encode(reinterpret_cast<const base58check::byte *>(payload), sizeof payload));
+	}
+	members.push_back(members[17]); // duplicates are stored once
+
+	std::vector<::base58check_item> items;
+	for (const auto &member : members)
+		items.push_back({ member.data(), member.size() });
+	items.push_back({ "3QJmnh", 6 });
+	items.push_back({ "1BitcoinEaterAddressDontSendf59kuF", 34 });
+	std::vector<int> results(items.size());
+	::base58check_set set;
+	size_t n_allocs = n_hook_allocs;
+	assert(::base58check_set_build(&set, items.data(), items.size(), 21, results.data()) == 0 && set.n_items == 2000);
+	assert(n_hook_allocs > n_allocs); // the image comes from the hooks
+	assert(results[2000] == 0 && results[2001] == BASE58CHECK_ELENGTH && results[2002] == BASE58CHECK_ECHECKSUM);
+	::base58check_set failed;
+	assert(::base58check_set_build(&failed, items.data(), items.size(), 21, nullptr) == BASE58CHECK_ELENGTH);
+	assert(::base58check_set_build(&failed, items.data(), items.size(), 0, nullptr) == BASE58CHECK_ESIZE);
+
+	auto check = [&](const ::base58check_set &s) {
+		for (const auto &member : members) {
+			assert(::base58check_set_contains(&s, member.data(), member.size()) == 1);
+			auto payload = base58check::decode(member.data(), member.size());
+			assert(::base58check_set_contains_payload(&s, reinterpret_cast<const unsigned char *>(payload.data()), payload.size()) == 1);
+			assert(::base58check_set_contains_payload(&s, reinterpret_cast<const unsigned char *>(payload.data()), payload.size() - 1) == 0);
+		}
+		for (const auto &other : others)
+			assert(::base58check_set_contains(&s, other.data(), other.size()) == 0);
+		assert(::base58check_set_contains(&s, "3QJmnh", 6) == BASE58CHECK_ELENGTH);
+		assert(::base58check_set_contains(&s, "1BitcoinEaterAddressDontSendf59kuF", 34) == BASE58CHECK_ECHECKSUM);
+	};
+	check(set);
+
+	// an image opens in place, wherever it came from, however it is aligned
+	::base58check_set view;
+	std::vector<unsigned char> copy(set.n_image + 1);
+	unsigned char *unaligned = copy.data() + 1;
+	std::memcpy(unaligned, set.image, set.n_image);
+	assert(::base58check_set_open(&view, unaligned, set.n_image) == 0 && view.n_items == 2000);
+	check(view);
+	assert(::base58check_set_open(&view, unaligned, set.n_image - 1) == BASE58CHECK_EFORMAT);
+	unaligned[0] ^= 1;
+	assert(::base58check_set_open(&view, unaligned, set.n_image) == BASE58CHECK_EFORMAT);
+
+	char path[] = "/tmp/base58check-set-XXXXXX";
+	int fd = ::mkstemp(path);
+	assert(fd >= 0);
+	::close(fd);
+	assert(::base58check_set_save(&set, path) == 0);
+	errno = 0;
+	assert(::base58check_set_save(&set, "/nonexistent/base58check-set") == BASE58CHECK_EIO && errno == ENOENT);
+	::base58check_set_free(&set);
+	assert(::base58check_set_map(&set, path) == 0);
+	check(set);
+	::base58check_set_free(&set);
+
+	base58check::address_set mapped = base58check::address_set::map(path);
+	assert(mapped.size() == 2000 && mapped.payload_size() == 21 && mapped.contains(members[0]) && !mapped.contains(others[0]));
+	::unlink(path);
+	try {
+		base58check::address_set::map(path);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::system_error &e) {
+		assert(e.code() == std::errc::no_such_file_or_directory);
+	}
+	members.pop_back();
+	base58check::address_set built(members, 21);
+	assert(built.size() == 2000 && built.contains(members[1999]) && !built.contains(others[999]));
+	try {
+		base58check::address_set bad(others, 20);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::invalid_argument &) {
+	}
+}
+
+static void test_pack() {
+	// payloads of several sizes, some with leading zeros, across several runs
+	std::vector<std::string> encodings;
+	std::vector<std::vector<base58check::byte>> payloads;
+	for (unsigned i = 0; i < 10000; ++i) {
+		std::vector<base58check::byte> payload(i % 7 == 0 ? i % 100 + 1 : 21);
+		for (size_t j = 0; j < payload.size(); ++j) {
+			uint64_t x = (i * 131 + j) * UINT64_C(0x9e3779b97f4a7c15);
+			payload[j] = static_cast<base58check::byte>(j < i % 3 ? 0 : (x ^ x >> 29) * UINT64_C(0xbf58476d1ce4e5b9) >> 56);
+		}
+		const base58check::byte *data = payload.data();
+		encodings.push_back(base58check::encode(data, payload.size()));
+		payloads.push_back(payload);
+	}
+	encodings.insert(encodings.begin() + 5, "1BitcoinEaterAddressDontSendf59kuF");
+	std::vector<::base58check_item> items;
+	std::string expect;
+	for (const auto &encoding : encodings) {
+		items.push_back({ encoding.data(), encoding.size() });
+		if (encoding != "1BitcoinEaterAddressDontSendf59kuF")
+			expect += encoding + '\n';
+	}
+
+	for (unsigned flags : { 0u, unsigned(BASE58CHECK_PACK_INDEX) }) {
+		std::vector<int> results(items.size());
+		unsigned char *image = nullptr;
+		size_t n_image = 0;
+		assert(::base58check_pack_batch(&image, &n_image, items.data(), items.size(), flags, nullptr) == BASE58CHECK_ECHECKSUM && !image);
+		assert(::base58check_pack_batch(&image, &n_image, items.data(), items.size(), flags, results.data()) == 0);
+		assert(results[5] == BASE58CHECK_ECHECKSUM && n_image <= ::base58check_pack_batch_buffer_size(items.data(), items.size(), flags));
+
+		::base58check_pack pack;
+		assert(::base58check_pack_open(&pack, image, n_image) == 0);
+		for (size_t i : { size_t(0), size_t(6), size_t(7), size_t(4999), size_t(9999) }) {
+			const unsigned char *payload;
+			size_t n_payload;
+			assert(::base58check_pack_record(&pack, i, &payload, &n_payload) == 0);
+			assert(n_payload == payloads[i].size() && std::memcmp(payload, payloads[i].data(), n_payload) == 0);
+		}
+		const unsigned char *payload;
+		size_t n_payload;
+		assert(::base58check_pack_record(&pack, 10000, &payload, &n_payload) == BASE58CHECK_ESIZE);
+
+		for (unsigned n_threads : { 1u, 4u }) {
+			char *out = nullptr;
+			size_t n_out = 0;
+			assert(::base58check_unpack(&out, &n_out, &pack, n_threads) == 0);
+			assert(std::string(out, n_out) == expect);
+			::base58check_free(out);
+		}
+		assert(::base58check_pack_open(&pack, image, 63) == BASE58CHECK_EFORMAT);
+		assert(::base58check_pack_open(&pack, image, n_image - 1) == BASE58CHECK_EFORMAT);
+		::base58check_free(image);
+	}
+
+	// payloads all of one size need no prefixes
+	items.erase(items.begin() + 5);
+	std::vector<::base58check_item> fixed;
+	for (size_t i = 0; i < items.size(); ++i)
+		if (payloads[i].size() == 21)
+			fixed.push_back(items[i]);
+	auto packed = base58check::pack(fixed.data(), fixed.size(), BASE58CHECK_PACK_INDEX);
+	assert(packed.size() == 64 + fixed.size() * 21);
+	std::string unpacked = base58check::unpack(packed.data(), packed.size());
+	assert(unpacked.size() == std::accumulate(fixed.begin(), fixed.end(), fixed.size(),
+			[](size_t n, const ::base58check_item &item) { return n + item.size; }));
+	assert(base58check::unpack(base58check::pack(fixed.data(), 0).data(), 64).empty());
+	try {
+		base58check::unpack(packed.data(), packed.size() - 1);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::invalid_argument &) {
+	}
+
+	// empty payloads are prefixed, so no pack holds more records than bytes
+	const ::base58check_item empty[] = { { "3QJmnh", 6 }, { "3QJmnh", 6 }, { "3QJmnh", 6 } };
+	packed = base58check::pack(empty, 3);
+	assert(packed.size() == 64 + 3 && base58check::unpack(packed.data(), packed.size()) == "3QJmnh\n3QJmnh\n3QJmnh\n");
+	unsigned char corrupt[64] = { 'B', '5', '8', 'C', 'P', 'A', 'K', 1 };
+	corrupt[12] = 0x10; // 2**36 records of no size
+	::base58check_pack pack;
+	assert(::base58check_pack_open(&pack, corrupt, sizeof corrupt) == BASE58CHECK_EFORMAT);
+	corrupt[16] = 21; // or of 21 bytes, in no bytes
+	assert(::base58check_pack_open(&pack, corrupt, sizeof corrupt) == BASE58CHECK_EFORMAT);
+}
+
+static void test_alphabet() {
+	static const char alphabet[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+	std::vector<base58check::byte> bytes(48);
+	for (size_t i = 0; i < bytes.size(); ++i)
+		bytes[i] = static_cast<base58check::byte>(i * 37 + 11);
+	const std::string valid = base58check::encode(static_cast<const base58check::byte *>(bytes.data()), bytes.size(), 0);
+	for (size_t pos : { size_t(0), size_t(5), size_t(31), size_t(32), size_t(63), valid.size() - 1 })
+		for (unsigned c = 0; c < 256; ++c) {
+			auto str = valid;
+			str[pos] = static_cast<char>(c);
+			unsigned char *out = nullptr;
+			size_t n_out = 0;
+			int ret = ::base58check_decode(&out, &n_out, str.data(), str.size(), 0);
+			assert(::base58check_verify(str.data(), str.size(), nullptr) == ret);
+			if (std::memchr(alphabet, static_cast<int>(c), sizeof alphabet - 1))
+				assert(ret != BASE58CHECK_ECHAR && (ret == 0) == (str == valid));
+			else
+				assert(ret == BASE58CHECK_ECHAR && !out);
+			if (ret == 0)
+				::base58check_free(out);
+		}
+}
+
+static uint64_t sum(const uint64_t (&counters)[BASE58CHECK_STATS_BUCKETS]) {
+	uint64_t n = 0;
+	for (uint64_t c : counters)
+		n += c;
+	return n;
+}
+
+static void test_stats() {
+	::base58check_stats before, after;
+	if (::base58check_stats_snapshot(&before) == BASE58CHECK_ENOTSUP) {
+		assert(before.encode.calls == 0 && sum(before.decode.latency) == 0);
+		return;
+	}
+	static const unsigned char data[] = { 0, 1, 2, 3, 4 };
+	char buf[16], *enc = buf;
+	size_t n_enc = sizeof buf;
+	assert(::base58check_encode(&enc, &n_enc, data, sizeof data, 0) == 0);
+	unsigned char bytes[32], *out = bytes;
+	size_t n_out = sizeof bytes;
+	assert(::base58check_decode_ex(nullptr, &out, &n_out, enc, n_enc, 0, 0) == 0);
+	n_out = sizeof bytes;
+	assert(::base58check_decode(&out, &n_out, "1BitcoinEaterAddressDontSendf59ku0", 34, 0) == BASE58CHECK_ECHAR);
+	n_out = sizeof bytes;
+	assert(::base58check_decode(&out, &n_out, "1BitcoinEaterAddressDontSendf59kuF", 34, 0) == BASE58CHECK_ECHECKSUM);
+	assert(::base58check_stats_snapshot(&after) == 0);
+
+	assert(after.encode.calls - before.encode.calls == 1);
+	assert(after.encode.bytes_in - before.encode.bytes_in == sizeof data);
+	assert(after.encode.bytes_out - before.encode.bytes_out == n_enc);
+	assert(sum(after.encode.latency) - sum(before.encode.latency) == 1);
+	assert(after.decode.calls - before.decode.calls == 3);
+	assert(after.decode.bytes_in - before.decode.bytes_in == n_enc + 34 + 34);
+	assert(after.decode.bytes_out - before.decode.bytes_out == sizeof data);
+	assert(after.decode.failures[-BASE58CHECK_ECHAR] - before.decode.failures[-BASE58CHECK_ECHAR] == 1);
+	assert(after.decode.failures[-BASE58CHECK_ECHECKSUM] - before.decode.failures[-BASE58CHECK_ECHECKSUM] == 1);
+	assert(sum(after.decode.latency) - sum(before.decode.latency) == 3);
+}
+
+static void count_candidate(void *, uint64_t index, unsigned char *payload, size_t n_payload) {
+	for (size_t i = n_payload; i-- > 0; index >>= 8)
+		payload[i] = static_cast<unsigned char>(index);
+}
+
+static int collect_match(void *opaque, const unsigned char *payload, size_t n_payload, const char *encoding, size_t n_encoding) {
+	auto &matches = *static_cast<std::vector<std::string> *>(opaque);
+	matches.emplace_back(encoding, n_encoding);
+	assert(base58check::encode(reinterpret_cast<const base58check::byte *>(payload), n_payload) == matches.back());
+	return 0;
+}
+
+static void test_search_prefix() {
+	// every 2-byte payload, so that matches are decided by checksums too
+	for (const char *prefix : { "1", "11", "2", "5H", "Ahm", "zz", "3QJ", "9" }) {
+		std::vector<std::string> expect;
+		size_t n_prefix = std::strlen(prefix);
+		for (unsigned i = 0; i < 65536; ++i) {
+			const base58check::byte payload[2] = { static_cast<base58check::byte>(i >> 8), static_cast<base58check::byte>(i) };
+			std::string enc = base58check::encode(payload, 2);
+			if (enc.compare(0, n_prefix, prefix) == 0)
+				expect.push_back(enc);
+		}
+		for (unsigned n_threads : { 1, 4 }) {
+			std::vector<std::string> matches;
+			::base58check_search search = { };
+			search.prefix = prefix, search.n_prefix = n_prefix, search.n_payload = 2;
+			search.candidate = count_candidate, search.match = collect_match, search.opaque = &matches;
+			search.max_candidates = 65536, search.n_threads = n_threads;
+			::base58check_search_stats stats;
+			assert(::base58check_search_prefix(&search, &stats) == 0);
+			assert(stats.candidates == 65536 && stats.matches == expect.size());
+			std::sort(matches.begin(), matches.end());
+			std::sort(expect.begin(), expect.end());
+			assert(matches == expect);
+		}
+	}
+
+	std::vector<std::string> matches;
+	static const unsigned char version[] = { 0x05 };
+	::base58check_search search = { };
+	search.prefix = "3Ab", search.n_prefix = 3, search.n_payload = 21;
+	search.head = version, search.n_head = sizeof version, search.seed = 58;
+	search.match = collect_match, search.opaque = &matches, search.max_matches = 2;
+	assert(::base58check_search_prefix(&search, nullptr) == 0);
+	assert(matches.size() == 2 && matches[0].compare(0, 3, "3Ab") == 0 && matches[1].compare(0, 3, "3Ab") == 0);
+	search.prefix = "1Ab";
+	assert(::base58check_search_prefix(&search, nullptr) == BASE58CHECK_ELENGTH);
+	search.prefix = "3Al";
+	assert(::base58check_search_prefix(&search, nullptr) == BASE58CHECK_ECHAR);
+	search.prefix = "3Ab", search.n_payload = 0;
+	assert(::base58check_search_prefix(&search, nullptr) == BASE58CHECK_ESIZE);
+	search.prefix = "1111", search.n_prefix = 4, search.n_payload = 3, search.n_head = 0;
+	assert(::base58check_search_prefix(&search, nullptr) == BASE58CHECK_ELENGTH);
+}
+
+static void test_raw() {
+	static const char hello[] = "Hello World!";
+	auto enc = base58check::encode_raw(reinterpret_cast<const base58check::byte *>(hello), sizeof hello - 1);
+	assert(enc == "2NEpo7TZRRrLZSi2U");
+	auto dec = base58check::decode_raw(enc.data(), enc.size());
+	assert(dec.size() == sizeof hello - 1 && std::memcmp(dec.data(), hello, dec.size()) == 0);
+
+	static const unsigned char zeros[] = { 0, 0, 0x28, 0x7f, 0xb4, 0xcd };
+	enc = base58check::encode_raw(reinterpret_cast<const base58check::byte *>(zeros), sizeof zeros);
+	assert(enc == "11233QC4");
+	dec = base58check::decode_raw(enc.data(), enc.size());
+	assert(dec.size() == sizeof zeros && std::memcmp(dec.data(), zeros, sizeof zeros) == 0);
+
+	assert(base58check::encode_raw(reinterpret_cast<const base58check::byte *>(zeros), 0).empty());
+	assert(base58check::decode_raw("", 0).empty());
+	assert(base58check::decode_raw("11", 2).size() == 2);
+	try {
+		base58check::decode_raw("0", 1);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::invalid_argument &) {
+	}
+}
+
+static void test_trusted() {
+	auto valid = base58check::decode("1BitcoinEaterAddressDontSendf59kuE", 34);
+	// the corrupted checksum is not noticed, but it is still stripped
+	auto trusted = base58check::decode_trusted("1BitcoinEaterAddressDontSendf59kuF", 34);
+	assert(trusted == valid);
+	unsigned char *out = nullptr;
+	size_t n_out = 0;
+	assert(::base58check_decode_ex(nullptr, &out, &n_out, "111", 3, 0, BASE58CHECK_TRUSTED) == BASE58CHECK_ELENGTH);
+	assert(::base58check_decode_ex(nullptr, &out, &n_out, "1BitcoinEaterAddressDontSend0", 29, 0, BASE58CHECK_TRUSTED) == BASE58CHECK_ECHAR);
+}
+
+// checks prefix encodings against encodings of the concatenated payloads
+static void test_prefix_encoder() {
+	static const std::vector<unsigned char> prefixes[] = {
+		{ 0x00 }, { 0x05 }, { 0x80 }, { 0x00, 0x00 }, { 0x04, 0x88, 0xb2, 0x1e, 0x00 },
+	};
+	for (const auto &prefix : prefixes)
+		for (size_t n_tail : { 0, 1, 20, 32, 73, 300 }) {
+			base58check::prefix_encoder enc(reinterpret_cast<const base58check::byte *>(prefix.data()), prefix.size(), n_tail);
+			for (size_t n : { n_tail, n_tail + 1, size_t(20) })
+				for (size_t n_zeros : { size_t(0), size_t(1), n }) {
+					std::vector<unsigned char> payload(prefix);
+					for (size_t i = 0; i < n; ++i)
+						payload.push_back(i < n_zeros ? 0 : static_cast<unsigned char>(i * 97 + n + 1));
+					const base58check::byte *tail = reinterpret_cast<const base58check::byte *>(payload.data() + prefix.size()),
+							*whole = reinterpret_cast<const base58check::byte *>(payload.data());
+					assert(enc.encode(tail, n) == base58check::encode(whole, payload.size()));
+					assert(enc.encode(tail, n, 3).substr(3) == base58check::encode(whole, payload.size()));
+				}
+		}
+
+	// a small payload whose tail is not of the expected size is converted on
+	// the stack
+	static const unsigned char version[] = { 0x00 }, tail[21] = { 1, 2, 3 };
+	base58check::prefix_encoder enc(reinterpret_cast<const base58check::byte *>(version), sizeof version, 20);
+	char buf[64], *p = buf;
+	size_t n_out = sizeof buf, n_allocs = n_hook_allocs;
+	assert(::base58check_prefix_encode(enc.get(), &p, &n_out, tail, sizeof tail, 0) == 0 && n_hook_allocs == n_allocs);
+}
+
+static void test_append() {
+	static const char addr[] = "1BitcoinEaterAddressDontSendf59kuE";
+	const auto bytes = base58check::decode(addr, sizeof addr - 1);
+	std::string str = "\"address\": \"";
+	base58check::encode_append(str, bytes.data(), bytes.size());
+	assert(str == std::string("\"address\": \"") + addr);
+	base58check::encode_append(str, bytes.data(), bytes.size(), 2);
+	assert(str.compare(str.size() - (sizeof addr + 1), 2, "\0\0", 2) == 0 && str.substr(str.size() - (sizeof addr - 1)) == addr);
+
+	std::vector<base58check::byte> out(3, base58check::byte(0xff));
+	base58check::decode_append(out, addr, sizeof addr - 1, 1);
+	assert(out.size() == 3 + 1 + bytes.size() && out[3] == base58check::byte(0) &&
+			std::equal(bytes.begin(), bytes.end(), out.begin() + 4));
+	try {
+		base58check::decode_append(out, "1BitcoinEaterAddressDontSendf59kuF", sizeof addr - 1);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::invalid_argument &) {
+		assert(out.size() == 3 + 1 + bytes.size());
+	}
+
+	// too large for the stack buffer
+	const std::vector<base58check::byte> large(300, base58check::byte(7));
+	std::string enc;
+	base58check::encode_append(enc, large.data(), large.size());
+	assert(enc == base58check::encode(large.data(), large.size()));
+	out.clear();
+	base58check::decode_append(out, enc.data(), enc.size());
+	assert(out == large);
+
+	std::string chars;
+	base58check::encode_to(std::back_inserter(chars), bytes.data(), bytes.size());
+	assert(chars == addr);
+	std::vector<base58check::byte> decoded;
+	base58check::decode_to(std::back_inserter(decoded), addr, sizeof addr - 1);
+	assert(decoded == bytes);
+	chars.clear();
+	base58check::encode_to(std::back_inserter(chars), large.data(), large.size());
+	assert(chars == enc);
+
+	// payloads that the library stages on the stack allocate nothing, even
+	// those long enough for divide-and-conquer conversion
+	for (size_t n : { 248, 252 }) {
+		const std::vector<base58check::byte> payload(n, base58check::byte(0xa5));
+		char buf[400], *p = buf;
+		size_t n_out = sizeof buf, n_allocs = n_hook_allocs;
+		assert(::base58check_encode(&p, &n_out, reinterpret_cast<const unsigned char *>(payload.data()), n, 0) == 0);
+		std::string s;
+		s.reserve(sizeof buf);
+		base58check::encode_append(s, payload.data(), n);
+		assert(n_hook_allocs == n_allocs && s == std::string(buf, n_out));
+	}
+
+#if __cplusplus >= 202002L
+	char buf[64];
+	size_t n = base58check::encode_into(buf, bytes.data(), bytes.size(), 1);
+	assert(std::string_view(buf + 1, n - 1) == addr);
+	try {
+		base58check::encode_into(std::span<char>(buf, 8), bytes.data(), bytes.size());
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::length_error &) {
+	}
+	std::array<base58check::byte, 32> raw;
+	n = base58check::decode_into(raw, addr);
+	assert(n == bytes.size() && std::equal(bytes.begin(), bytes.end(), raw.begin()));
+	try {
+		base58check::decode_into(std::span<base58check::byte>(), addr);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const std::length_error &) {
+	}
+#endif
+}
+
+#if __cpp_lib_memory_resource >= 201603L
+static void test_pmr() {
+	counting_allocator counts = { 0, 0 };
+	struct counting_resource : std::pmr::memory_resource {
+		counting_allocator &counts;
+		explicit counting_resource(counting_allocator &counts) : counts(counts) { }
+		void * do_allocate(size_t size, size_t) override { return counting_alloc(&counts, size); }
+		void do_deallocate(void *ptr, size_t size, size_t) override { counting_free(&counts, ptr, size); }
+		bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+	} mr(counts);
+
+	{
+		static const char addr[] = "1BitcoinEaterAddressDontSendf59kuE";
+		auto bytes = base58check::pmr::decode(addr, 0, &mr);
+		assert(bytes.get_allocator().resource() == &mr && counts.n_allocs == 1);
+		auto str = base58check::pmr::encode(std::as_const(bytes).data(), bytes.size(), 0, &mr);
+		assert(str == addr && counts.n_allocs == 2);
+
+		// large inputs take the library's scratch space from the resource too
+		std::vector<base58check::byte> large(5000, base58check::byte(0xa5));
+		auto enc = base58check::pmr::encode(std::as_const(large).data(), large.size(), 0, &mr);
+		assert(counts.n_allocs > 3 && std::string_view(enc) == base58check::encode(std::as_const(large).data(), large.size()));
+		auto dec = base58check::pmr::decode(enc, 0, &mr);
+		assert(std::equal(dec.begin(), dec.end(), large.begin(), large.end()));
+
+		// nothing but the string is allocated, from the resource or the hooks
+		for (size_t n : { 248, 252 }) {
+			const std::vector<base58check::byte> payload(n, base58check::byte(0xa5));
+			size_t n_allocs = counts.n_allocs, n_hook = n_hook_allocs;
+			auto s = base58check::pmr::encode(payload.data(), n, 0, &mr);
+			assert(counts.n_allocs == n_allocs + 1 && n_hook_allocs == n_hook);
+			assert(std::string_view(s) == base58check::encode(payload.data(), n));
+		}
+
+		std::pmr::polymorphic_allocator<char> alloc(&mr);
+		auto s = base58check::encode(std::as_const(bytes).data(), bytes.size(), 1, alloc);
+		assert(s.size() == sizeof addr && s[0] == '\0' && s.compare(1, s.npos, addr) == 0);
+		auto v = base58check::decode(addr, sizeof addr - 1, 0, std::pmr::polymorphic_allocator<base58check::byte>(&mr));
+		assert(v.size() == bytes.size() && std::equal(v.begin(), v.end(), bytes.begin()));
+	}
+	assert(counts.n_live == 0);
+}
+#endif
+
+#if __cplusplus >= 202002L
+static void test_views() {
+	static const char *const strs[] = {
+		"3QJmnh", "1BitcoinEaterAddressDontSendf59kuF", "1111111111111111111114oLvT2",
+		"", "1BitcoinEaterAddressDontSendf59kuE", "0OIl",
+	};
+	static const int expect[] = {
+		0, BASE58CHECK_ECHECKSUM, 0, BASE58CHECK_ELENGTH, 0, BASE58CHECK_ECHAR,
+	};
+	// more elements than fit in one of the views' groups
+	std::vector<std::string_view> in;
+	for (size_t i = 0; i < 150; ++i)
+		in.push_back(strs[i % 6]);
+	std::vector<std::vector<base58check::byte>> payloads;
+	std::vector<std::string_view> valid;
+	size_t i = 0;
+	for (auto item : in | base58check::views::decode) {
+		assert(item.error == expect[i % 6]);
+		if (item) {
+			assert(std::ranges::equal(item.data, base58check::decode(in[i])));
+			payloads.emplace_back(item.data.begin(), item.data.end());
+			valid.push_back(in[i]);
+		}
+		else
+			assert(item.data.empty());
+		++i;
+	}
+	assert(i == in.size());
+
+	i = 0;
+	for (auto item : base58check::views::encode(payloads)) {
+		assert(item && item.text == valid[i]);
+		++i;
+	}
+	assert(i == payloads.size());
+
+	payloads.emplace_back();
+	auto view = payloads | base58check::views::encode;
+	auto it = view.begin();
+	std::ranges::advance(it, static_cast<std::ptrdiff_t>(payloads.size() - 1));
+	assert((*it).text == "3QJmnh");
+	assert(++it == view.end());
+}
+#endif
+
 static void test_empty_input_with_hdr() {
 	unsigned char buf[4], *out = buf;
 	size_t n_out = sizeof buf;
@@ -46,6 +909,48 @@ int main() {
 	test_invalid("1BitcoinEaterAddressDontSendf59kuF");
 
 	test_empty_input_with_hdr();
+	test_alphabet();
+	test_raw();
+	test_decode_inplace();
+	test_address_set();
+	test_pack();
+	test_stats();
+	test_search_prefix();
+	test_trusted();
+	test_prefix_encoder();
+	test_append();
+
+	test_encode_batch();
+	test_decode_batch();
+	test_batch_lengths();
+	test_context();
+	test_allocator();
+
+	for (size_t n : { 120, 127, 128, 129, 136, 200, 251, 252, 253, 580, 581, 582, 583, 584, 585, 2000, 5000, 33333 })
+		test_large(n, 0);
+	test_large(4096, 1);
+	test_large(100000, 7);
+
+#if __cplusplus >= 201703L
+	test_fixed<21>("1BitcoinEaterAddressDontSendf59kuE");
+	test_fixed<21>("1111111111111111111114oLvT2");
+	test_fixed<0>("3QJmnh");
+	test_fixed_round_trip<1>();
+	test_fixed_round_trip<21>();
+	test_fixed_round_trip<25>();
+	test_fixed_round_trip<34>();
+	test_fixed_round_trip<78>();
+	test_fixed_round_trip<82>();
+	test_fixed_invalid();
+	test_decode_as();
+#endif
+#if __cpp_lib_memory_resource >= 201603L
+	test_pmr();
+#endif
+#if __cplusplus >= 202002L
+	test_constant();
+	test_views();
+#endif
 
 	return 0;
 }